@@ -0,0 +1,115 @@
+/* acct.c - Per-process CPU time accounting
+ * vim:ts=4 noexpandtab
+ *
+ * Every CPU keeps a TSC stamp and a mode. Each time the mode changes (syscall/interrupt
+ * entry and exit) or curr_pid changes (schedule, execute, halt) the cycles since the stamp
+ * are added to curr_pid's utime or stime. Since each interrupt/syscall frame remembers the
+ * mode it interrupted, a process that gets switched out in the middle of an interrupt
+ * picks the right mode back up when it's resumed.
+ */
+
+#include "acct.h"
+#include "clock.h"
+#include "smp.h"
+#include "pid.h"
+#include "lib.h"
+
+/* Local functions */
+static void cycles_to_timeval(uint64_t cycles, timeval_t* tv);
+
+/* acct_init
+ * 
+ * Starts charging the calling CPU's time to whatever curr_pid is (in kernel mode)
+ * Inputs: None
+ * Outputs: None
+ */
+void acct_init() {
+    if (tsc_khz == 0) return;
+    this_cpu()->acct_stamp = rdtsc();
+    this_cpu()->acct_mode = ACCT_KERNEL;
+}
+
+/* acct_charge
+ * 
+ * Adds the cycles since the last stamp to curr_pid in the current mode
+ * Inputs: None
+ * Outputs: None
+ */
+void acct_charge() {
+    cpu_t* cpu = this_cpu();
+    uint64_t now;
+
+    if (tsc_khz == 0) return;
+
+    now = rdtsc();
+    if (cpu->acct_mode == ACCT_USER) pcbs[curr_pid]->utime += now - cpu->acct_stamp;
+    else if (cpu->acct_mode == ACCT_KERNEL) pcbs[curr_pid]->stime += now - cpu->acct_stamp;
+    cpu->acct_stamp = now;
+}
+
+uint32_t acct_switch(uint32_t mode) {
+    cpu_t* cpu = this_cpu();
+    uint32_t old = cpu->acct_mode;
+
+    acct_charge();
+    cpu->acct_mode = mode;
+    return old;
+}
+
+uint32_t acct_enter() {
+    return acct_switch(ACCT_KERNEL);
+}
+
+void acct_exit(uint32_t mode) {
+    acct_switch(mode);
+}
+
+/* acct_reap
+ * 
+ * Called from halt so a parent's children totals include everything its child ran
+ * (the child's own children included), like wait() does on Unix
+ * Inputs: pid - halting process
+ *         parent - its parent
+ * Outputs: None
+ */
+void acct_reap(uint32_t pid, uint32_t parent) {
+    pcbs[parent]->cutime += pcbs[pid]->utime + pcbs[pid]->cutime;
+    pcbs[parent]->cstime += pcbs[pid]->stime + pcbs[pid]->cstime;
+}
+
+/* acct_getrusage
+ * 
+ * Inputs: pid - process to report on
+ *         who - RUSAGE_SELF or RUSAGE_CHILDREN
+ *         ru - filled with the user and system times
+ * Outputs: None
+ */
+void acct_getrusage(uint32_t pid, int32_t who, rusage_t* ru) {
+    acct_charge();
+    if (who == RUSAGE_CHILDREN) {
+        cycles_to_timeval(pcbs[pid]->cutime, &ru->utime);
+        cycles_to_timeval(pcbs[pid]->cstime, &ru->stime);
+    } else {
+        cycles_to_timeval(pcbs[pid]->utime, &ru->utime);
+        cycles_to_timeval(pcbs[pid]->stime, &ru->stime);
+    }
+}
+
+/* acct_ms
+ * 
+ * Inputs: cycles - TSC cycles, e.g. a PCB's utime
+ * Outputs: the same time in milliseconds
+ */
+uint32_t acct_ms(uint64_t cycles) {
+    uint64_t ms = cycles_to_ns(cycles);
+    div64_32(&ms, NS_PER_MS);
+    return (uint32_t)ms;
+}
+
+/* Converts TSC cycles to seconds and microseconds */
+static void cycles_to_timeval(uint64_t cycles, timeval_t* tv) {
+    uint64_t us = cycles_to_ns(cycles);
+    div64_32(&us, NS_PER_SEC / US_PER_SEC);
+    tv->usec = div64_32(&us, US_PER_SEC);
+    tv->sec = (uint32_t)us;
+}
@@ -0,0 +1,61 @@
+/* acct.h - Per-process CPU time accounting
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _ACCT_H
+#define _ACCT_H
+
+#include "types.h"
+
+/* What the CPU is doing, time is charged to curr_pid's utime/stime (idle time isn't charged) */
+#define ACCT_USER           0
+#define ACCT_KERNEL         1
+#define ACCT_IDLE           2
+
+/* getrusage targets (same values as Unix) */
+#define RUSAGE_SELF         0
+#define RUSAGE_CHILDREN     -1
+
+#define US_PER_SEC          1000000
+
+#ifndef ASM
+
+/* Seconds and microseconds */
+typedef struct timeval {
+    uint32_t sec;
+    uint32_t usec;
+} timeval_t;
+
+/* CPU time returned by getrusage */
+typedef struct rusage {
+    timeval_t utime;        /* Time spent running user code */
+    timeval_t stime;        /* Time spent in the kernel on the process' behalf */
+} rusage_t;
+
+/* Starts accounting on the calling CPU (needs a calibrated TSC) */
+extern void acct_init();
+
+/* Charges the time since the last charge to curr_pid, call before curr_pid changes */
+extern void acct_charge();
+
+/* Charges the time so far and switches to a new mode, returns the old mode */
+extern uint32_t acct_switch(uint32_t mode);
+
+/* Called on interrupt/syscall entry, returns the mode to restore on exit */
+extern uint32_t acct_enter();
+
+/* Called on interrupt/syscall exit with whatever acct_enter returned */
+extern void acct_exit(uint32_t mode);
+
+/* Adds a halting process' times (and its children's) to its parent's children totals */
+extern void acct_reap(uint32_t pid, uint32_t parent);
+
+/* Converts TSC cycles of CPU time to milliseconds */
+extern uint32_t acct_ms(uint64_t cycles);
+
+/* Fills in a process' (or its reaped children's) CPU times */
+extern void acct_getrusage(uint32_t pid, int32_t who, rusage_t* ru);
+
+#endif /* _ACCT_H */
+
+#endif /* ASM */
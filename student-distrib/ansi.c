@@ -0,0 +1,164 @@
+/* ansi.c - Escape sequence parser for terminal output
+ * vim:ts=4 noexpandtab
+ *
+ * A small subset of the VT100/ECMA-48 parser state machine: ESC x and ESC [ params final
+ * sequences, nothing else (no OSC/DCS strings, intermediates make a sequence ignored).
+ * Every byte is looked up in ansi_class and then in ansi_table by the parser's state,
+ * which gives what to do with it and the next state. The parser only collects the
+ * sequence, lib.c does what it says to the console.
+ *
+ * Plain text never gets here, putbuf only calls ansi_step for ESC or while a sequence
+ * is in progress.
+ */
+
+#include "ansi.h"
+
+/* Byte classes */
+#define C_CTRL      0                       /* C0 controls, run even in the middle of a sequence */
+#define C_ESC       1                       /* Starts over */
+#define C_CAN       2                       /* CAN/SUB, cancel the sequence */
+#define C_INTER     3                       /* 0x20-0x2F */
+#define C_DIGIT     4
+#define C_SEMI      5                       /* ; and : separate params */
+#define C_PRIV      6                       /* < = > ? */
+#define C_LBRACKET  7                       /* [ */
+#define C_FINAL     8                       /* 0x40-0x7E */
+#define C_OTHER     9                       /* DEL and bytes >= 0x80 */
+#define C_COUNT     10
+
+/* Actions on top of ANSI_NONE/PUT/CSI/ESC_FINAL, handled here and never returned */
+#define A_CLEAR     4                       /* Start a CSI sequence */
+#define A_PARAM     5                       /* Add a digit to the current param */
+#define A_SEP       6                       /* Start the next param */
+#define A_PRIV      7                       /* Private marker */
+
+/* A table entry is the action in the high nibble and the next state in the low one */
+#define T(action, state)    (((action) << 4) | (state))
+
+static const uint8_t ansi_class[256] = {
+    [0x00 ... 0x1F] = C_CTRL,
+    [0x18] = C_CAN,
+    [0x1A] = C_CAN,
+    [ANSI_ESC] = C_ESC,
+    [0x20 ... 0x2F] = C_INTER,
+    [0x30 ... 0x39] = C_DIGIT,
+    [0x3A ... 0x3B] = C_SEMI,
+    [0x3C ... 0x3F] = C_PRIV,
+    [0x40 ... 0x7E] = C_FINAL,
+    ['['] = C_LBRACKET,
+    [0x7F ... 0xFF] = C_OTHER,
+};
+
+static const uint8_t ansi_table[ANSI_STATES][C_COUNT] = {
+    [ANSI_GROUND] = {
+        [C_CTRL]     = T(ANSI_PUT, ANSI_GROUND),
+        [C_ESC]      = T(ANSI_NONE, ANSI_ESCAPE),
+        [C_CAN]      = T(ANSI_PUT, ANSI_GROUND),
+        [C_INTER]    = T(ANSI_PUT, ANSI_GROUND),
+        [C_DIGIT]    = T(ANSI_PUT, ANSI_GROUND),
+        [C_SEMI]     = T(ANSI_PUT, ANSI_GROUND),
+        [C_PRIV]     = T(ANSI_PUT, ANSI_GROUND),
+        [C_LBRACKET] = T(ANSI_PUT, ANSI_GROUND),
+        [C_FINAL]    = T(ANSI_PUT, ANSI_GROUND),
+        [C_OTHER]    = T(ANSI_PUT, ANSI_GROUND),
+    },
+    [ANSI_ESCAPE] = {
+        [C_CTRL]     = T(ANSI_PUT, ANSI_ESCAPE),
+        [C_ESC]      = T(ANSI_NONE, ANSI_ESCAPE),
+        [C_CAN]      = T(ANSI_NONE, ANSI_GROUND),
+        [C_INTER]    = T(ANSI_NONE, ANSI_ESCAPE),
+        [C_DIGIT]    = T(ANSI_ESC_FINAL, ANSI_GROUND),
+        [C_SEMI]     = T(ANSI_ESC_FINAL, ANSI_GROUND),
+        [C_PRIV]     = T(ANSI_ESC_FINAL, ANSI_GROUND),
+        [C_LBRACKET] = T(A_CLEAR, ANSI_CSI_ENTRY),
+        [C_FINAL]    = T(ANSI_ESC_FINAL, ANSI_GROUND),
+        [C_OTHER]    = T(ANSI_NONE, ANSI_GROUND),
+    },
+    [ANSI_CSI_ENTRY] = {
+        [C_CTRL]     = T(ANSI_PUT, ANSI_CSI_ENTRY),
+        [C_ESC]      = T(ANSI_NONE, ANSI_ESCAPE),
+        [C_CAN]      = T(ANSI_NONE, ANSI_GROUND),
+        [C_INTER]    = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_DIGIT]    = T(A_PARAM, ANSI_CSI_PARAM),
+        [C_SEMI]     = T(A_SEP, ANSI_CSI_PARAM),
+        [C_PRIV]     = T(A_PRIV, ANSI_CSI_PARAM),
+        [C_LBRACKET] = T(ANSI_CSI, ANSI_GROUND),
+        [C_FINAL]    = T(ANSI_CSI, ANSI_GROUND),
+        [C_OTHER]    = T(ANSI_NONE, ANSI_CSI_ENTRY),
+    },
+    [ANSI_CSI_PARAM] = {
+        [C_CTRL]     = T(ANSI_PUT, ANSI_CSI_PARAM),
+        [C_ESC]      = T(ANSI_NONE, ANSI_ESCAPE),
+        [C_CAN]      = T(ANSI_NONE, ANSI_GROUND),
+        [C_INTER]    = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_DIGIT]    = T(A_PARAM, ANSI_CSI_PARAM),
+        [C_SEMI]     = T(A_SEP, ANSI_CSI_PARAM),
+        [C_PRIV]     = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_LBRACKET] = T(ANSI_CSI, ANSI_GROUND),
+        [C_FINAL]    = T(ANSI_CSI, ANSI_GROUND),
+        [C_OTHER]    = T(ANSI_NONE, ANSI_CSI_PARAM),
+    },
+    [ANSI_CSI_IGNORE] = {
+        [C_CTRL]     = T(ANSI_PUT, ANSI_CSI_IGNORE),
+        [C_ESC]      = T(ANSI_NONE, ANSI_ESCAPE),
+        [C_CAN]      = T(ANSI_NONE, ANSI_GROUND),
+        [C_INTER]    = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_DIGIT]    = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_SEMI]     = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_PRIV]     = T(ANSI_NONE, ANSI_CSI_IGNORE),
+        [C_LBRACKET] = T(ANSI_NONE, ANSI_GROUND),
+        [C_FINAL]    = T(ANSI_NONE, ANSI_GROUND),
+        [C_OTHER]    = T(ANSI_NONE, ANSI_CSI_IGNORE),
+    },
+};
+
+/* ansi_step
+ *
+ * Inputs: p - parser
+ *         ch - next byte written
+ * Outputs: ANSI_NONE if the parser kept the byte, ANSI_PUT if it should be written like
+ *          any other character, ANSI_CSI or ANSI_ESC_FINAL if it is the final byte of a
+ *          sequence (the params stay in p until the next sequence starts)
+ */
+int32_t ansi_step(ansi_t* p, uint8_t ch) {
+    uint8_t t = ansi_table[p->state][ansi_class[ch]];
+    uint16_t* param;
+
+    p->state = t & 0x0F;
+
+    switch (t >> 4) {
+        case A_CLEAR:
+            p->priv = 0;
+            p->nparams = 1;
+            p->params[0] = 0;
+            return ANSI_NONE;
+        case A_PARAM:
+            /* Past ANSI_MAX_PARAMS the digits go nowhere */
+            if (p->nparams > ANSI_MAX_PARAMS) return ANSI_NONE;
+            param = &p->params[p->nparams - 1];
+            *param = *param * 10 + (ch - '0');
+            if (*param > ANSI_PARAM_MAX) *param = ANSI_PARAM_MAX;
+            return ANSI_NONE;
+        case A_SEP:
+            if (p->nparams > ANSI_MAX_PARAMS) return ANSI_NONE;
+            if (p->nparams++ < ANSI_MAX_PARAMS) p->params[p->nparams - 1] = 0;
+            return ANSI_NONE;
+        case A_PRIV:
+            p->priv = ch;
+            return ANSI_NONE;
+        default:
+            return t >> 4;
+    }
+}
+
+/* ansi_param
+ *
+ * Inputs: p - parser that just returned ANSI_CSI
+ *         i - which param
+ *         def - value to use if it is missing or 0
+ * Outputs: the param
+ */
+int32_t ansi_param(const ansi_t* p, int32_t i, int32_t def) {
+    if (i >= p->nparams || i >= ANSI_MAX_PARAMS || !p->params[i]) return def;
+    return p->params[i];
+}
@@ -0,0 +1,50 @@
+/* ansi.h - Escape sequence parser for terminal output
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _ANSI_H
+#define _ANSI_H
+
+#include "types.h"
+
+/* Starts every escape sequence */
+#define ANSI_ESC            0x1B
+
+/* Parameters kept per sequence, extra ones are dropped */
+#define ANSI_MAX_PARAMS     8
+
+/* Largest value a parameter counts up to */
+#define ANSI_PARAM_MAX      9999
+
+/* Parser states, ANSI_GROUND is plain text */
+#define ANSI_GROUND         0
+#define ANSI_ESCAPE         1               /* After ESC */
+#define ANSI_CSI_ENTRY      2               /* After ESC [ */
+#define ANSI_CSI_PARAM      3               /* In the parameters */
+#define ANSI_CSI_IGNORE     4               /* Malformed, skip to the final byte */
+#define ANSI_STATES         5
+
+/* What ansi_step tells the caller to do with the byte */
+#define ANSI_NONE           0               /* Nothing, the parser kept it */
+#define ANSI_PUT            1               /* Write it like any other character (text or a control) */
+#define ANSI_CSI            2               /* It ends a CSI sequence, the params are in the parser */
+#define ANSI_ESC_FINAL      3               /* It ends a two byte ESC sequence */
+
+#ifndef ASM
+
+typedef struct ansi {
+    uint8_t state;
+    uint8_t priv;                           /* '?' (or another private marker) before the params, 0 if none */
+    uint8_t nparams;
+    uint16_t params[ANSI_MAX_PARAMS];
+} ansi_t;
+
+/* Feeds one byte to the parser, returns one of ANSI_NONE/PUT/CSI/ESC_FINAL */
+extern int32_t ansi_step(ansi_t* p, uint8_t ch);
+
+/* Parameter i of the last sequence, def if it is missing or 0 */
+extern int32_t ansi_param(const ansi_t* p, int32_t i, int32_t def);
+
+#endif /* _ANSI_H */
+
+#endif /* ASM */
@@ -0,0 +1,192 @@
+/* apic.c - Local APIC and I/O APIC support
+ * vim:ts=4 noexpandtab
+ */
+
+#include "apic.h"
+#include "paging.h"
+#include "lib.h"
+#include "pit.h"
+#include "clock.h"
+#include "smp.h"
+
+/* Local functions */
+static uint32_t ioapic_read(uint32_t reg);
+static void ioapic_write(uint32_t reg, uint32_t val);
+
+int32_t apic_present = 0;
+uint32_t ioapic_pins = 0;
+int32_t lapic_timer_on = 0;
+
+/* Timer counts per PIT_TICK_MS (one-shot mode), 0 when using TSC-deadline mode */
+static uint32_t lapic_tick_count = 0;
+
+/* TSC cycles per PIT_TICK_MS (TSC-deadline mode) */
+static uint64_t tsc_tick_cycles = 0;
+
+/* Virtual (identity mapped) address of the local APIC registers */
+static uint32_t lapic_base = 0;
+
+/* apic_init
+ * 
+ * Maps the APIC page uncached and enables the BSP's local APIC. The i8259 keeps delivering
+ * device interrupts through LINT0 (virtual wire mode set up by the BIOS), so every I/O APIC
+ * pin is masked to make sure nothing gets delivered twice.
+ * Inputs: None
+ * Outputs: None
+ */
+void apic_init() {
+    uint32_t eax = 1, ebx, ecx, edx;
+    uint64_t base;
+    int i;
+
+    asm volatile ("cpuid"
+            : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+    );
+    if (!(edx & CPUID_APIC)) return;
+
+    /* Make sure the APIC is globally enabled and find where it lives */
+    base = rdmsr(LAPIC_BASE_MSR);
+    wrmsr(LAPIC_BASE_MSR, base | LAPIC_BASE_ENABLE);
+    lapic_base = (uint32_t)base & LAPIC_BASE_MASK;
+
+    /* We only map the standard 4MB region holding both APICs */
+    if ((lapic_base >> 22) != APIC_PD) return;
+    page_mmio(APIC_PD);
+
+    lapic_enable(1);
+    apic_present = 1;
+
+    /* Mask every I/O APIC pin, the max redirection entry is in bits 16-23 of the version */
+    ioapic_pins = ((ioapic_read(IOAPIC_VER) >> 16) & 0xFF) + 1;
+    for (i = 0; i < ioapic_pins; i++) {
+        ioapic_write(IOAPIC_REDTBL(i), IOAPIC_MASKED);
+        ioapic_write(IOAPIC_REDTBL(i) + 1, 0);
+    }
+}
+
+/* lapic_enable
+ * 
+ * Software enables the calling CPU's local APIC with our spurious vector. APs mask LINT0
+ * so only the BSP takes i8259 interrupts.
+ * Inputs: bsp - 1 on the bootstrap processor, 0 on an AP
+ * Outputs: None
+ */
+void lapic_enable(int32_t bsp) {
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_IDT_NUM);
+    if (!bsp) lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+}
+
+/* Local APIC register access, registers are 32 bits on 16 byte boundaries */
+uint32_t lapic_read(uint32_t reg) {
+    return *(volatile uint32_t*)(lapic_base + reg);
+}
+
+void lapic_write(uint32_t reg, uint32_t val) {
+    *(volatile uint32_t*)(lapic_base + reg) = val;
+}
+
+uint32_t lapic_id() {
+    return lapic_read(LAPIC_ID) >> LAPIC_ID_SHIFT;
+}
+
+void lapic_eoi() {
+    lapic_write(LAPIC_EOI, 0);
+}
+
+/* lapic_send_ipi
+ * 
+ * Sends an IPI and spins until the local APIC has delivered it
+ * Inputs: dest - APIC id of the target (ignored for shorthand destinations)
+ *         icr - low half of the interrupt command register
+ * Outputs: None
+ */
+void lapic_send_ipi(uint32_t dest, uint32_t icr) {
+    lapic_write(LAPIC_ICR_HIGH, dest << LAPIC_ID_SHIFT);
+    lapic_write(LAPIC_ICR_LOW, icr);
+    while (lapic_read(LAPIC_ICR_LOW) & ICR_DELIVERY_PENDING);
+}
+
+/* lapic_timer_init
+ * 
+ * Replaces the PIT as the scheduler clock. TSC-deadline mode is used when the CPU has it
+ * (deadlines come straight from the already calibrated TSC and never drift), otherwise the
+ * timer runs in one-shot mode after counting how far it gets during a PIT channel 2 countdown.
+ * Either way reprogramming it is one MSR/MMIO write instead of PIT port I/O, and every CPU
+ * has its own.
+ * Inputs: None
+ * Outputs: 0 if the LAPIC timer is now driving the tick, -1 if the caller should use the PIT
+ */
+int32_t lapic_timer_init() {
+    uint32_t eax = 1, ebx, ecx, edx;
+    uint32_t flags, elapsed;
+
+    if (!apic_present) return -1;
+
+    asm volatile ("cpuid"
+            : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+    );
+
+    cli_and_save(flags);
+
+    if ((ecx & CPUID_TSC_DEADLINE) && tsc_khz != 0) {
+        tsc_tick_cycles = (uint64_t)tsc_khz * PIT_TICK_MS;
+        lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_DEADLINE | LAPIC_TIMER_IDT_NUM);
+    } else {
+        /* Count down from the top for one calibration period (masked so it can't fire) */
+        lapic_write(LAPIC_TIMER_DCR, LAPIC_TIMER_DIV16);
+        lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_ONESHOT | LAPIC_TIMER_IDT_NUM);
+        pit_ch2_start(CLOCK_CALIBRATE_MS);
+        lapic_write(LAPIC_TIMER_ICR, 0xFFFFFFFF);
+        pit_ch2_wait();
+        elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CCR);
+        lapic_write(LAPIC_TIMER_ICR, 0);
+
+        lapic_tick_count = (elapsed / CLOCK_CALIBRATE_MS) * PIT_TICK_MS;
+        if (lapic_tick_count == 0) {
+            restore_flags(flags);
+            return -1;
+        }
+        lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_ONESHOT | LAPIC_TIMER_IDT_NUM);
+    }
+
+    this_cpu()->timer_deadline = rdtsc();
+    lapic_timer_on = 1;
+    lapic_timer_arm();
+
+    restore_flags(flags);
+    return 0;
+}
+
+/* lapic_timer_arm
+ * 
+ * Arms the calling CPU's timer for the next tick. Deadlines are spaced exactly one tick
+ * apart (skipping ahead if we fell behind) so handler latency doesn't add up.
+ * Inputs: None
+ * Outputs: None
+ */
+void lapic_timer_arm() {
+    cpu_t* cpu = this_cpu();
+    uint64_t now;
+
+    if (lapic_tick_count != 0) {
+        lapic_write(LAPIC_TIMER_ICR, lapic_tick_count);
+        return;
+    }
+
+    now = rdtsc();
+    cpu->timer_deadline += tsc_tick_cycles;
+    if ((int64_t)(cpu->timer_deadline - now) <= 0) cpu->timer_deadline = now + tsc_tick_cycles;
+    wrmsr(TSC_DEADLINE_MSR, cpu->timer_deadline);
+}
+
+/* I/O APIC registers are reached by writing the index to REGSEL and using WINDOW */
+static uint32_t ioapic_read(uint32_t reg) {
+    *(volatile uint32_t*)(IOAPIC_ADDR + IOAPIC_REGSEL) = reg;
+    return *(volatile uint32_t*)(IOAPIC_ADDR + IOAPIC_WINDOW);
+}
+
+static void ioapic_write(uint32_t reg, uint32_t val) {
+    *(volatile uint32_t*)(IOAPIC_ADDR + IOAPIC_REGSEL) = reg;
+    *(volatile uint32_t*)(IOAPIC_ADDR + IOAPIC_WINDOW) = val;
+}
@@ -0,0 +1,128 @@
+/* apic.h - Local APIC and I/O APIC support
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _APIC_H
+#define _APIC_H
+
+#include "types.h"
+
+/* CPUID.1:EDX bit showing the CPU has a local APIC */
+#define CPUID_APIC              (1 << 9)
+
+/* IA32_APIC_BASE MSR */
+#define LAPIC_BASE_MSR          0x1B
+#define LAPIC_BASE_BSP          (1 << 8)
+#define LAPIC_BASE_ENABLE       (1 << 11)
+#define LAPIC_BASE_MASK         0xFFFFF000
+
+/* Default physical addresses, both live in the 4MB page at 0xFEC00000 */
+#define IOAPIC_ADDR             0xFEC00000
+#define APIC_PD                 (IOAPIC_ADDR >> 22)     /* 1019 */
+
+/* Local APIC register offsets */
+#define LAPIC_ID                0x020
+#define LAPIC_VERSION           0x030
+#define LAPIC_TPR               0x080
+#define LAPIC_EOI               0x0B0
+#define LAPIC_SVR               0x0F0
+#define LAPIC_ICR_LOW           0x300
+#define LAPIC_ICR_HIGH          0x310
+#define LAPIC_LVT_TIMER         0x320
+#define LAPIC_LVT_LINT0         0x350
+#define LAPIC_LVT_LINT1         0x360
+#define LAPIC_TIMER_ICR         0x380
+#define LAPIC_TIMER_CCR         0x390
+#define LAPIC_TIMER_DCR         0x3E0
+
+#define LAPIC_SVR_ENABLE        0x100
+#define LAPIC_LVT_MASKED        0x10000
+#define LAPIC_ID_SHIFT          24
+
+/* Timer modes (LVT timer bits 17-18) and divide by 16 */
+#define LAPIC_TIMER_ONESHOT     0x00000
+#define LAPIC_TIMER_DEADLINE    0x40000
+#define LAPIC_TIMER_DIV16       0x3
+
+/* TSC-deadline mode support and its MSR */
+#define CPUID_TSC_DEADLINE      (1 << 24)
+#define TSC_DEADLINE_MSR        0x6E0
+
+/* Interrupt command register fields */
+#define ICR_INIT                0x00000500
+#define ICR_STARTUP             0x00000600
+#define ICR_LEVEL_ASSERT        0x00004000
+#define ICR_DELIVERY_PENDING    0x00001000
+#define ICR_ALL_BUT_SELF        0x000C0000
+
+/* I/O APIC registers (accessed through the select/window pair) */
+#define IOAPIC_REGSEL           0x00
+#define IOAPIC_WINDOW           0x10
+#define IOAPIC_VER              0x01
+#define IOAPIC_REDTBL(pin)      (0x10 + 2 * (pin))
+#define IOAPIC_MASKED           0x10000
+
+/* Spurious interrupts from the local APIC land here (low 4 bits must be 1s) */
+#define LAPIC_SPURIOUS_IDT_NUM  0xFF
+
+/* Local APIC timer vector (above the i8259's 0x20-0x2F) */
+#define LAPIC_TIMER_IDT_NUM     0x40
+
+#ifndef ASM
+
+/* Set once the BSP's local APIC is mapped and enabled */
+extern int32_t apic_present;
+
+/* Number of I/O APIC input pins (0 if there is no I/O APIC) */
+extern uint32_t ioapic_pins;
+
+/* Set once the local APIC timer has replaced the PIT as the scheduler tick */
+extern int32_t lapic_timer_on;
+
+/* Reads a model specific register */
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint64_t val;
+    asm volatile ("rdmsr"
+            : "=A"(val)
+            : "c"(msr)
+    );
+    return val;
+}
+
+/* Writes a model specific register */
+static inline void wrmsr(uint32_t msr, uint64_t val) {
+    asm volatile ("wrmsr"
+            :
+            : "c"(msr), "A"(val)
+            : "memory"
+    );
+}
+
+/* Maps and enables the BSP's local APIC and masks the I/O APIC */
+extern void apic_init();
+
+/* Enables the local APIC of the CPU calling it (APs) */
+extern void lapic_enable(int32_t bsp);
+
+/* Reads/writes a local APIC register */
+extern uint32_t lapic_read(uint32_t reg);
+extern void lapic_write(uint32_t reg, uint32_t val);
+
+/* APIC id of the calling CPU */
+extern uint32_t lapic_id();
+
+/* Signals the end of a local APIC interrupt */
+extern void lapic_eoi();
+
+/* Sends an inter-processor interrupt and waits for it to be accepted */
+extern void lapic_send_ipi(uint32_t dest, uint32_t icr);
+
+/* Calibrates the local APIC timer against the PIT and starts the scheduler tick on it */
+extern int32_t lapic_timer_init();
+
+/* Arms the next tick (one-shot timers need this every tick) */
+extern void lapic_timer_arm();
+
+#endif /* _APIC_H */
+
+#endif /* ASM */
@@ -0,0 +1,162 @@
+/* clock.c - TSC based monotonic clock calibrated against the PIT
+ * vim:ts=4 noexpandtab
+ */
+
+#include "clock.h"
+#include "pit.h"
+#include "timer.h"
+#include "vdso.h"
+#include "lib.h"
+
+/* Local functions */
+static uint32_t tsc_present();
+static uint32_t pit_calibrate_tsc();
+
+uint32_t tsc_khz = 0;
+
+/* TSC value at calibration (time 0) and the cycle -> ns multiplier */
+static uint64_t tsc_base;
+static uint32_t ns_mult;
+
+/* tsc_present
+ * 
+ * Checks CPUID for a time stamp counter
+ * Inputs: None
+ * Outputs: 1 if rdtsc can be used, 0 if not
+ */
+static uint32_t tsc_present() {
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile ("cpuid"
+            : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+    );
+    return (edx & CPUID_TSC) ? 1 : 0;
+}
+
+/* pit_calibrate_tsc
+ * 
+ * Counts TSC cycles while PIT channel 2 counts down CLOCK_CALIBRATE_MS in mode 0. Channel 2
+ * is only wired to the speaker so this doesn't touch the scheduler tick on channel 0. The
+ * shortest of a few runs is kept since anything that stalls us only makes a run longer.
+ * Interrupts must be off.
+ * Inputs: None
+ * Outputs: TSC frequency in kHz
+ */
+static uint32_t pit_calibrate_tsc() {
+    int i;
+    uint32_t best = 0xFFFFFFFF;
+    uint64_t start, delta;
+
+    for (i = 0; i < CLOCK_CALIBRATE_RUNS; i++) {
+        pit_ch2_start(CLOCK_CALIBRATE_MS);
+        start = rdtsc();
+        pit_ch2_wait();
+        delta = rdtsc() - start;
+
+        /* A 10 ms run only overflows 32 bits above 400 GHz */
+        if ((delta >> 32) == 0 && (uint32_t)delta < best) best = (uint32_t)delta;
+    }
+
+    return best / CLOCK_CALIBRATE_MS;
+}
+
+/* clock_init
+ * 
+ * Calibrates the TSC and sets up the ns/us multipliers, both for the kernel and for user
+ * programs reading the clock through the vdso page
+ * Inputs: None
+ * Outputs: None
+ */
+void clock_init() {
+    uint32_t flags;
+    uint64_t mult;
+
+    if (!tsc_present()) return;
+
+    cli_and_save(flags);
+    tsc_khz = pit_calibrate_tsc();
+    tsc_base = rdtsc();
+    restore_flags(flags);
+
+    if (tsc_khz == 0) return;
+
+    /* mult = (10^6 ns per ms << shift) / (cycles per ms) */
+    mult = (uint64_t)NS_PER_MS << CLOCK_NS_SHIFT;
+    div64_32(&mult, tsc_khz);
+    ns_mult = (uint32_t)mult;
+
+    vdso_begin_update();
+    vdso_page.data.tsc_base = tsc_base;
+    vdso_page.data.tsc_khz = tsc_khz;
+    vdso_page.data.ns_mult = ns_mult;
+    vdso_page.data.ns_shift = CLOCK_NS_SHIFT;
+    mult = (uint64_t)US_PER_MS << CLOCK_US_SHIFT;
+    div64_32(&mult, tsc_khz);
+    vdso_page.data.us_mult = (uint32_t)mult;
+    vdso_page.data.us_shift = CLOCK_US_SHIFT;
+    vdso_end_update();
+}
+
+/* cycles_to_ns
+ * 
+ * Converts a TSC cycle count (usually a difference of two rdtsc()'s) to nanoseconds
+ * Inputs: cycles - number of TSC cycles
+ * Outputs: nanoseconds
+ */
+uint64_t cycles_to_ns(uint64_t cycles) {
+    return mul_u64_u32_shr(cycles, ns_mult, CLOCK_NS_SHIFT);
+}
+
+/* clock_ns
+ * 
+ * Reads the monotonic clock, falls back to PIT tick resolution without a TSC
+ * Inputs: None
+ * Outputs: nanoseconds since clock_init()
+ */
+uint64_t clock_ns() {
+    if (tsc_khz == 0) return (uint64_t)timer_ticks * PIT_TICK_MS * NS_PER_MS;
+    return tsc_to_ns(rdtsc());
+}
+
+/* tsc_to_ns
+ * 
+ * Converts an earlier rdtsc() reading to the clock_ns() time it was taken at
+ * Inputs: tsc - value read from the TSC after clock_init()
+ * Outputs: nanoseconds since clock_init()
+ */
+uint64_t tsc_to_ns(uint64_t tsc) {
+    return cycles_to_ns(tsc - tsc_base);
+}
+
+/* clock_udelay
+ * 
+ * Spins on the TSC for at least us microseconds (used for hardware delays before the
+ * scheduler is running)
+ * Inputs: us - microseconds to wait
+ * Outputs: None
+ */
+void clock_udelay(uint32_t us) {
+    uint64_t cycles, start;
+    uint32_t i;
+
+    if (tsc_khz == 0) {
+        for (i = 0; i < us; i++) outb(0, IO_DELAY_PORT);
+        return;
+    }
+
+    cycles = (uint64_t)us * tsc_khz;
+    div64_32(&cycles, US_PER_MS);
+    start = rdtsc();
+    while (rdtsc() - start < cycles);
+}
+
+/* clock_gettime
+ * 
+ * Splits the monotonic clock into seconds and nanoseconds
+ * Inputs: ts - time value to fill in
+ * Outputs: None
+ */
+void clock_gettime(timespec_t* ts) {
+    uint64_t ns = clock_ns();
+    ts->nsec = div64_32(&ns, NS_PER_SEC);
+    ts->sec = (uint32_t)ns;
+}
@@ -0,0 +1,60 @@
+/* clock.h - TSC based monotonic clock calibrated against the PIT
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+#include "types.h"
+
+/* Length of one calibration run on PIT channel 2, best of CLOCK_CALIBRATE_RUNS is kept */
+#define CLOCK_CALIBRATE_MS      10
+#define CLOCK_CALIBRATE_RUNS    3
+
+/* Fixed point shifts for cycle -> ns and cycle -> us conversions
+ * ns = (cycles * ns_mult) >> CLOCK_NS_SHIFT, the mults fit in 32 bits for any TSC above ~4 MHz */
+#define CLOCK_NS_SHIFT          24
+#define CLOCK_US_SHIFT          32
+
+#define NS_PER_SEC              1000000000
+#define NS_PER_MS               1000000
+#define US_PER_MS               1000
+
+/* Writing to the POST code port takes about 1 us, used for delays without a TSC */
+#define IO_DELAY_PORT           0x80
+
+/* CPUID.1:EDX bit showing the TSC exists */
+#define CPUID_TSC               (1 << 4)
+
+#ifndef ASM
+
+/* Time value handed to user programs by clock_gettime */
+typedef struct timespec {
+    uint32_t sec;       /* Seconds since the clock was calibrated */
+    uint32_t nsec;      /* Nanoseconds within the second (0 to 999999999) */
+} timespec_t;
+
+/* TSC frequency in kHz (0 if there is no TSC and the clock falls back to PIT ticks) */
+extern uint32_t tsc_khz;
+
+/* Calibrates the TSC against PIT channel 2 and publishes the result in the vdso page */
+extern void clock_init();
+
+/* Nanoseconds since clock_init() */
+extern uint64_t clock_ns();
+
+/* Converts an rdtsc() reading to nanoseconds since clock_init() */
+extern uint64_t tsc_to_ns(uint64_t tsc);
+
+/* Converts a TSC cycle count to nanoseconds */
+extern uint64_t cycles_to_ns(uint64_t cycles);
+
+/* Busy waits for at least us microseconds */
+extern void clock_udelay(uint32_t us);
+
+/* Fills ts with the current monotonic time */
+extern void clock_gettime(timespec_t* ts);
+
+#endif /* _CLOCK_H */
+
+#endif /* ASM */
@@ -5,12 +5,14 @@
 #include "lib.h"
 #include "x86_inter.h"
 #include "pid.h"
+#include "apic.h"
 
 /* local functions */
 static void exceptions_init();
 static void keyboard_idt_init();
 static void rtc_idt_init();
 static void pit_idt_init();
+static void apic_idt_init();
 static void sys_call_init();
 
 /* Exception string table */
@@ -55,6 +57,8 @@ void IDT_init() {
 
     pit_idt_init();
 
+    apic_idt_init();
+
     // Initialize the system calls for IDT
     sys_call_init();
 
@@ -256,3 +260,30 @@ static void pit_idt_init() {
     /* Set handler for keyboard IDT entry by linking to pit_handler() */
     SET_IDT_ENTRY(idt[PIT_IDT_NUM], &pit_handler_link);
 }
+
+/* apic_idt_init
+ * Description: Initialize the IDT entries for the local APIC timer and spurious
+    *              interrupts, spurious ones don't need an EOI so the handler just returns
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Initializes the spurious vector.
+*/
+static void apic_idt_init() {
+    idt[LAPIC_TIMER_IDT_NUM].seg_selector = KERNEL_CS;
+    idt[LAPIC_TIMER_IDT_NUM].present = 1;
+    idt[LAPIC_TIMER_IDT_NUM].size = 1;
+    idt[LAPIC_TIMER_IDT_NUM].reserved1 = 1;
+    idt[LAPIC_TIMER_IDT_NUM].reserved2 = 1;
+    idt[LAPIC_TIMER_IDT_NUM].reserved3 = 0;
+
+    SET_IDT_ENTRY(idt[LAPIC_TIMER_IDT_NUM], &lapic_timer_handler_link);
+
+    idt[LAPIC_SPURIOUS_IDT_NUM].seg_selector = KERNEL_CS;
+    idt[LAPIC_SPURIOUS_IDT_NUM].present = 1;
+    idt[LAPIC_SPURIOUS_IDT_NUM].size = 1;
+    idt[LAPIC_SPURIOUS_IDT_NUM].reserved1 = 1;
+    idt[LAPIC_SPURIOUS_IDT_NUM].reserved2 = 1;
+    idt[LAPIC_SPURIOUS_IDT_NUM].reserved3 = 0;
+
+    SET_IDT_ENTRY(idt[LAPIC_SPURIOUS_IDT_NUM], &lapic_spurious_link);
+}
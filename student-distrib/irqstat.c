@@ -0,0 +1,96 @@
+/* irqstat.c - Per-vector interrupt and exception counters
+ * vim:ts=4 noexpandtab
+ *
+ * A handler's time runs from irqstat_enter to irqstat_exit on its CPU. Timer handlers
+ * usually switch to another process before they return, so the switch points charge
+ * what the handler used so far (irqstat_switch) and the rest of the handler, which
+ * runs when the process is switched back in, isn't counted. Only the BSP takes device
+ * interrupts, so the totals aren't shared between CPUs.
+ */
+
+#include "irqstat.h"
+#include "lib.h"
+#include "clock.h"
+#include "smp.h"
+
+static irq_count_t irq_counts[IRQSTAT_VECTORS];
+
+/* irqstat_enter
+ * 
+ * Inputs: vector - IDT vector of the handler being entered
+ * Outputs: vector of the handler this one interrupted (IRQSTAT_NONE if none)
+ */
+int32_t irqstat_enter(uint32_t vector) {
+    cpu_t* cpu = this_cpu();
+    int32_t prev = cpu->irq_vector;
+    uint64_t now = tsc_khz ? rdtsc() : 0;
+
+    /* A handler interrupted by an exception stops its clock until the exception is done */
+    if (prev != IRQSTAT_NONE) irq_counts[prev].cycles += now - cpu->irq_stamp;
+
+    irq_counts[vector].count++;
+    cpu->irq_vector = vector;
+    cpu->irq_stamp = now;
+    return prev;
+}
+
+/* irqstat_exit
+ * 
+ * Inputs: prev - what the matching irqstat_enter returned
+ * Outputs: None
+ */
+void irqstat_exit(int32_t prev) {
+    cpu_t* cpu = this_cpu();
+    uint64_t now = tsc_khz ? rdtsc() : 0;
+
+    if (cpu->irq_vector != IRQSTAT_NONE) irq_counts[cpu->irq_vector].cycles += now - cpu->irq_stamp;
+
+    cpu->irq_vector = prev;
+    cpu->irq_stamp = now;
+}
+
+/* irqstat_switch
+ * 
+ * Inputs: None
+ * Outputs: None
+ */
+void irqstat_switch() {
+    cpu_t* cpu = this_cpu();
+    uint64_t now = tsc_khz ? rdtsc() : 0;
+
+    if (cpu->irq_vector != IRQSTAT_NONE) irq_counts[cpu->irq_vector].cycles += now - cpu->irq_stamp;
+    cpu->irq_vector = IRQSTAT_NONE;
+}
+
+/* irqstat_read
+ * 
+ * Inputs: stats - array to fill
+ *         count - number of entries stats has room for
+ * Outputs: number of entries written
+ */
+int32_t irqstat_read(irq_stat_t* stats, int32_t count) {
+    uint32_t flags;
+    uint32_t vector;
+    int32_t n = 0;
+    uint64_t t;
+
+    cli_and_save(flags);
+    for (vector = 0; vector < IRQSTAT_VECTORS && n < count; vector++) {
+        if (irq_counts[vector].count == 0) continue;
+
+        stats[n].vector = vector;
+        stats[n].count = irq_counts[vector].count;
+
+        t = cycles_to_ns(irq_counts[vector].cycles);
+        div64_32(&t, NS_PER_MS / US_PER_MS);
+        stats[n].time_us = (uint32_t)t;
+
+        t = irq_counts[vector].cycles;
+        div64_32(&t, irq_counts[vector].count);
+        stats[n].avg_cycles = (uint32_t)t;
+        n++;
+    }
+    restore_flags(flags);
+
+    return n;
+}
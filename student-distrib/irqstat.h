@@ -0,0 +1,45 @@
+/* irqstat.h - Per-vector interrupt and exception counters
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _IRQSTAT_H
+#define _IRQSTAT_H
+
+#include "types.h"
+
+#define IRQSTAT_VECTORS     256
+
+/* cpu_t.irq_vector while the CPU isn't running a counted handler */
+#define IRQSTAT_NONE        -1
+
+#ifndef ASM
+
+/* Totals for one vector */
+typedef struct irq_count {
+    uint32_t count;                         /* Times the handler was entered */
+    uint64_t cycles;                        /* TSC cycles spent in the handler */
+} irq_count_t;
+
+/* One vector as returned by KSTAT_IRQ */
+typedef struct irq_stat {
+    uint32_t vector;
+    uint32_t count;
+    uint32_t time_us;                       /* Total time spent in the handler */
+    uint32_t avg_cycles;                    /* TSC cycles per call */
+} irq_stat_t;
+
+/* Called by the interrupt/exception links before the handler, returns the vector to pass to irqstat_exit */
+extern int32_t irqstat_enter(uint32_t vector);
+
+/* Called by the links after the handler with whatever irqstat_enter returned */
+extern void irqstat_exit(int32_t prev);
+
+/* Charges the running handler up to now, call before switching to another process' stack */
+extern void irqstat_switch();
+
+/* Fills stats with the vectors that have fired, lowest first, returns how many */
+extern int32_t irqstat_read(irq_stat_t* stats, int32_t count);
+
+#endif /* _IRQSTAT_H */
+
+#endif /* ASM */
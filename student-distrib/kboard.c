@@ -258,6 +258,34 @@ uint8_t check_states(key_map *output) {
 
     return c;
 }
+/* void edit_line(uint8_t key)
+ * Inputs: key - next key from the terminal's key ring
+ * Return Value: void
+ * Function: adds a key to the line being typed in the reader's terminal and echoes it,
+ *           enter_flag is set once the line is done. Runs in terminal_read, so everything
+ *           here works on terminal_active and its screen
+ */
+void edit_line(uint8_t key) {
+    /* Up and down go through the saved commands */
+    if (key == KEY_UP || key == KEY_DOWN) {
+        type_command(key == KEY_UP);
+        return;
+    }
+
+    /* Other control characters (Ctrl+letter) don't go in a line */
+    if (key < ' ' && key != '\t' && key != '\b' && key != '\n') return;
+
+    /* check if it is a backspace because we do not add that to buffer or print it */
+    if (key == '\b') backspace_pressed();
+
+    /* BEFORE MODIFYING OUR BUFFER WE CHECK IF WE HAVE OVERFLOW */
+    /* if our buffer is full i.e. we are at index 126 (i = 127 is our \n) we dont do anything*/
+    if (check_buffer_overflow(key)) return;
+
+    /* add our character to the buffer and output to screen*/
+    add_to_buffer(key);
+}
+
 /* void backspace_pressed()
  * Inputs: none
  * Return Value: void
@@ -269,39 +297,39 @@ uint8_t check_states(key_map *output) {
 void backspace_pressed() {
     int i;
     /* get our current buffer idx for our terminal */
-    int buf_idx = terminal_ctx[terminal_shown].buf_idx;
+    int buf_idx = terminal_ctx[terminal_active].buf_idx;
 
     if (!buf_idx) return;
 
     buf_idx--;
     /* if we see a tab in buf that means we backspace 3 times*/
-    if (terminal_ctx[terminal_shown].keyboard_buf[buf_idx] == '\t') {
+    if (terminal_ctx[terminal_active].keyboard_buf[buf_idx] == '\t') {
         for (i = 0; i < 3; i++, buf_idx--) {
             putc('\b');
-            terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = 0;
+            terminal_ctx[terminal_active].keyboard_buf[buf_idx] = 0;
         }
     } else {
-        terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = 0;
+        terminal_ctx[terminal_active].keyboard_buf[buf_idx] = 0;
     }
 
     /* update the buf_idx for the struct */
-    terminal_ctx[terminal_shown].buf_idx = buf_idx;
+    terminal_ctx[terminal_active].buf_idx = buf_idx;
 }
 
-/* void add_to_buffer(unsigned char c, key_map *output)
- * Inputs: unsigned char c, key_map *output
+/* void add_to_buffer(unsigned char c)
+ * Inputs: unsigned char c
  * Return Value: void
  * Function: adds the character c to the keyboard buffer if appropriate,
  * after checking for tab and backspace and adding/removing spaces from the buffer accordingly.
  *  
  */
-void add_to_buffer(unsigned char c, key_map *output) {
+void add_to_buffer(unsigned char c) {
     int i;
     /* get our current buffer idx for our terminal */
-    int buf_idx = terminal_ctx[terminal_shown].buf_idx;
+    int buf_idx = terminal_ctx[terminal_active].buf_idx;
     
-    switch(output->scancode) {
-        case TAB:
+    switch(c) {
+        case '\t':
         {
             /* If we see a tab, add 3 spaces to the buffer and screen */
 
@@ -310,30 +338,30 @@ void add_to_buffer(unsigned char c, key_map *output) {
             
             
             for (i = 0; i < 3; i++, buf_idx++) {
-                terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = ' ';
+                terminal_ctx[terminal_active].keyboard_buf[buf_idx] = ' ';
                 putc(' ');
             }
-            terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = '\t'; // Insert '\t' into the buffer
+            terminal_ctx[terminal_active].keyboard_buf[buf_idx] = '\t'; // Insert '\t' into the buffer
             buf_idx++;
             putc(' '); // output a space instead of the tab character
             break;
         }
-        case BACKSPACE:
+        case '\b':
         {
             // If it's a backspace, we output the backspace char
             putc('\b');
             break;
         }
-        case ENTER:
+        case '\n':
         {   
             /* Don't allow enter spam */
-            if (!terminal_ctx[terminal_shown].enter_flag) {
+            if (!terminal_ctx[terminal_active].enter_flag) {
                 /* Get saved_commands ptr from terminal info */
-                saved_commands = terminal_ctx[terminal_shown].saved_commands;
+                saved_commands = terminal_ctx[terminal_active].saved_commands;
 
                 /* Save command if command is not empty */
                 if (buf_idx > 0) { 
-                    memcpy(saved_commands[top_scommands_idx].command, terminal_ctx[terminal_shown].keyboard_buf, BUF_SIZE);
+                    memcpy(saved_commands[top_scommands_idx].command, terminal_ctx[terminal_active].keyboard_buf, BUF_SIZE);
                     saved_commands[curr_scommands_idx].history = 0;
                     saved_commands[top_scommands_idx].history = 1;
                     if (++top_scommands_idx >= SAVED_COMMANDS_SIZE) top_scommands_idx = 0;
@@ -341,9 +369,9 @@ void add_to_buffer(unsigned char c, key_map *output) {
                 }
 
                 /* Enter */
-                terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = '\n';
+                terminal_ctx[terminal_active].keyboard_buf[buf_idx] = '\n';
                 buf_idx++;
-                terminal_ctx[terminal_shown].enter_flag = 1;
+                terminal_ctx[terminal_active].enter_flag = 1;
                 putc('\n');
             }
             break;
@@ -351,7 +379,7 @@ void add_to_buffer(unsigned char c, key_map *output) {
         default:
         {
             // For other characters, add them to the buffer and print
-            terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = c;
+            terminal_ctx[terminal_active].keyboard_buf[buf_idx] = c;
             buf_idx++;
             putc(c);
             break;
@@ -359,7 +387,7 @@ void add_to_buffer(unsigned char c, key_map *output) {
     }
 
     /* update the buf_idx for the struct */
-    terminal_ctx[terminal_shown].buf_idx = buf_idx;
+    terminal_ctx[terminal_active].buf_idx = buf_idx;
 }
 
 
@@ -370,34 +398,34 @@ void add_to_buffer(unsigned char c, key_map *output) {
  */
 void add_to_buffer_scommand(unsigned char c) {
     /* get our current buffer idx for our terminal */
-    int buf_idx = terminal_ctx[terminal_shown].buf_idx;
+    int buf_idx = terminal_ctx[terminal_active].buf_idx;
 
     // For other characters, add them to the buffer and print
-    terminal_ctx[terminal_shown].keyboard_buf[buf_idx] = c;
+    terminal_ctx[terminal_active].keyboard_buf[buf_idx] = c;
     buf_idx++;
     putc(c);
 
     /* update the buf_idx for the struct */
-    terminal_ctx[terminal_shown].buf_idx = buf_idx;
+    terminal_ctx[terminal_active].buf_idx = buf_idx;
 }
 
 
-/* int check_buffer_over_flow()
- * Inputs: none
+/* int check_buffer_over_flow(uint8_t c)
+ * Inputs: c - key about to be added
  * Return Value: 1 if buffer is full, 0 if not
  * Function: checks if the buffer is full and sets the buffer full flag accordingly
  *  
  */
-int check_buffer_overflow(key_map *output_key) {
+int check_buffer_overflow(uint8_t c) {
 
-    if ((terminal_ctx[terminal_shown].buf_idx) < BUF_SIZE - 1) return 0;
+    if ((terminal_ctx[terminal_active].buf_idx) < BUF_SIZE - 1) return 0;
 
     /* wait to receive enter before resetting our buffer idx (this is the only character that can work if we are i = 126)*/
-    if(output_key->scancode == ENTER) {
+    if(c == '\n') {
         /*add our \n to the end of our string idx 127 and output it*/
-        terminal_ctx[terminal_shown].keyboard_buf[BUF_SIZE - 1] = '\n';
+        terminal_ctx[terminal_active].keyboard_buf[BUF_SIZE - 1] = '\n';
         putc('\n');
-        terminal_ctx[terminal_shown].enter_flag = 1;
+        terminal_ctx[terminal_active].enter_flag = 1;
     }
 
     return 1;
@@ -413,10 +441,10 @@ void type_command(int32_t dir) {
     int i = 0;
 
     /* Get saved_command ptr from terminal info */
-    saved_commands = terminal_ctx[terminal_shown].saved_commands;
+    saved_commands = terminal_ctx[terminal_active].saved_commands;
 
     /* Save command */
-    memcpy(saved_commands[curr_scommands_idx].command, terminal_ctx[terminal_shown].keyboard_buf, BUF_SIZE);
+    memcpy(saved_commands[curr_scommands_idx].command, terminal_ctx[terminal_active].keyboard_buf, BUF_SIZE);
 
     /* User pressed up */
     if (dir) {
@@ -463,13 +491,13 @@ void type_command(int32_t dir) {
 void clear_keyboard_buf_scommand() {
     int i;
     for (i = 0; i < BUF_SIZE; i++) {
-        if (terminal_ctx[terminal_shown].keyboard_buf[i]) {
-            terminal_ctx[terminal_shown].keyboard_buf[i] = 0;
+        if (terminal_ctx[terminal_active].keyboard_buf[i]) {
+            terminal_ctx[terminal_active].keyboard_buf[i] = 0;
             putc('\b');
         }
     }
 
-    terminal_ctx[terminal_shown].buf_idx = 0;
-    terminal_ctx[terminal_shown].terminal_x = 0;
+    terminal_ctx[terminal_active].buf_idx = 0;
+    terminal_ctx[terminal_active].terminal_x = 0;
 }
 
@@ -45,6 +45,12 @@
 #define  BACKSPACE  0x0E
 #define  TAB        0x0F
 #define  CAPS_LOCK   0x3A
+#define  PAGE_UP     0x49
+#define  PAGE_DOWN   0x51
+
+/* Key ring values for the arrow keys, past every character the keyboard makes */
+#define  KEY_UP      0x80
+#define  KEY_DOWN    0x81
 
 /* keyboard buffer size */
 #define  BUF_SIZE   128
@@ -94,6 +100,7 @@ extern void enable_kboard_interrupt();
 
 extern void kboard_init();
 
+
 /* pressed keys */
 extern key_map key_letters[NUM_LETTERS];
 
@@ -117,11 +124,15 @@ extern void check_keys(uint8_t scancode, uint8_t data,  key_map *output_key);
 
 extern uint8_t check_states(key_map *output_key);
 
+/* THESE RUN IN THE READER, ON terminal_active */
+
+extern void edit_line(uint8_t key);
+
 extern void backspace_pressed();
 
-extern void add_to_buffer(uint8_t c, key_map *output);
+extern void add_to_buffer(uint8_t c);
 
-extern int check_buffer_overflow();
+extern int check_buffer_overflow(uint8_t c);
 
 extern void type_command(int32_t dir);
 
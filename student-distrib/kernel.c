@@ -17,6 +17,13 @@
 #include "syscall.h"
 #include "pid.h"
 #include "pit.h"
+#include "timer.h"
+#include "clock.h"
+#include "vdso.h"
+#include "apic.h"
+#include "smp.h"
+#include "acct.h"
+#include "serial.h"
 
 #define RUN_TESTS
 
@@ -37,6 +44,7 @@ void entry(unsigned long magic, unsigned long addr) {
     multiboot_info_t *mbi;
 
     /* Clear the screen. */
+    console_init();
     clear();
 
     /* Am I booted by a Multiboot-compliant boot loader? */
@@ -189,9 +197,27 @@ void entry(unsigned long magic, unsigned long addr) {
 
     kboard_init();
 
-    /* Enable and initiailize PIT */
-    pit_init();
-    enable_pit_interrupt();
+    /* COM1 for profiler dumps */
+    serial_init();
+
+    /* Calibrate the TSC against PIT channel 2 before channel 0 starts ticking */
+    vdso_init();
+    clock_init();
+
+    /* Local/I/O APIC, then wake up the other CPUs (the i8259 keeps handling device IRQs) */
+    apic_init();
+    smp_init();
+
+    /* Start charging CPU time to processes */
+    acct_init();
+
+    /* Start the scheduler tick (and the timer wheel it drives) on the local APIC timer,
+     * or on the PIT if there isn't one */
+    timer_init();
+    if (lapic_timer_init() == -1) {
+        pit_init();
+        enable_pit_interrupt();
+    }
 
     /* Enable interrupts after initiailizing all devices, paging, and PID's */
     sti();
@@ -0,0 +1,111 @@
+/* kstat.c - Kernel statistics exported to user programs
+ * vim:ts=4 noexpandtab
+ */
+
+#include "kstat.h"
+#include "lib.h"
+#include "acct.h"
+#include "scheduler.h"
+#include "latency.h"
+#include "trace.h"
+#include "profile.h"
+#include "irqstat.h"
+#include "sysstat.h"
+#include "strace.h"
+
+static int32_t kstat_proc(procstat_t* ps, int32_t count);
+static int32_t kstat_latency(lat_hist_t* hists, int32_t count);
+
+/* kstat_read
+ * 
+ * Inputs: which - KSTAT_* value picking what to report
+ *         buf - buffer to fill (already checked by the caller)
+ *         nbytes - size of buf
+ * Outputs: number of entries written, -1 if which is invalid
+ */
+int32_t kstat_read(int32_t which, void* buf, int32_t nbytes) {
+    switch (which) {
+        case KSTAT_PROC:
+            return kstat_proc((procstat_t*)buf, nbytes / sizeof(procstat_t));
+        case KSTAT_LATENCY:
+            return kstat_latency((lat_hist_t*)buf, nbytes / sizeof(lat_hist_t));
+        case KSTAT_TRACE:
+            return trace_read((trace_event_t*)buf, nbytes / sizeof(trace_event_t));
+        case KSTAT_PROFILE:
+            return profile_read((profile_sample_t*)buf, nbytes / sizeof(profile_sample_t));
+        case KSTAT_IRQ:
+            return irqstat_read((irq_stat_t*)buf, nbytes / sizeof(irq_stat_t));
+        case KSTAT_SYSCALL:
+            return sysstat_read((sys_stat_t*)buf, nbytes / sizeof(sys_stat_t));
+        case KSTAT_STRACE:
+            return strace_read((strace_rec_t*)buf, nbytes / sizeof(strace_rec_t));
+        default:
+            return -1;
+    }
+}
+
+/* kstat_proc
+ * 
+ * Inputs: ps - array to fill with one entry per process in use, lowest pid first
+ *         count - number of entries ps has room for
+ * Outputs: number of entries written
+ */
+static int32_t kstat_proc(procstat_t* ps, int32_t count) {
+    uint32_t flags;
+    int32_t n = 0;
+    int pid, i;
+    pcb_t* pcb;
+
+    cli_and_save(flags);
+
+    /* Bring the caller's own times up to date */
+    acct_charge();
+
+    for (pid = 0; pid < PID_NUM && n < count; pid++) {
+        pcb = pcbs[pid];
+        if (!pcb->in_use) continue;
+
+        ps[n].pid = pcb->pid;
+        ps[n].parent_pid = pcb->parent_pid;
+        ps[n].terminal = pcb->terminal;
+        ps[n].nice = pcb->nice;
+        ps[n].utime_ms = acct_ms(pcb->utime);
+        ps[n].stime_ms = acct_ms(pcb->stime);
+
+        if (active_processes[pcb->terminal] != pid) ps[n].state = PROC_WAITING;
+        else if (pcb->sleeping) ps[n].state = PROC_SLEEPING;
+        else ps[n].state = PROC_RUNNING;
+
+        ps[n].mem_bytes = pcb->image_size + PID_SIZE;
+        if (pcb->vidmap) ps[n].mem_bytes += PAGE_SIZE;
+
+        ps[n].open_fds = 0;
+        for (i = 0; i < FD_ARRAY_SIZE; i++)
+            if (fda_spaces[pid][i]) ps[n].open_fds++;
+
+        strncpy((int8_t*)ps[n].name, (const int8_t*)pcb->name, MAX_FILE_NAME_LENGTH);
+        ps[n].name[MAX_FILE_NAME_LENGTH] = '\0';
+        n++;
+    }
+
+    restore_flags(flags);
+    return n;
+}
+
+/* kstat_latency
+ * 
+ * Inputs: hists - array to fill with copies of lat_hists
+ *         count - number of entries hists has room for
+ * Outputs: number of entries written
+ */
+static int32_t kstat_latency(lat_hist_t* hists, int32_t count) {
+    uint32_t flags;
+
+    if (count > TERMINAL_COUNT * LAT_SOURCES) count = TERMINAL_COUNT * LAT_SOURCES;
+
+    cli_and_save(flags);
+    memcpy(hists, lat_hists, count * sizeof(lat_hist_t));
+    restore_flags(flags);
+
+    return count;
+}
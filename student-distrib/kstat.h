@@ -0,0 +1,46 @@
+/* kstat.h - Kernel statistics exported to user programs
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _KSTAT_H
+#define _KSTAT_H
+
+#include "types.h"
+#include "pid.h"
+
+/* What the kstat syscall reports on */
+#define KSTAT_PROC          0               /* One procstat_t per process in use */
+#define KSTAT_LATENCY       1               /* lat_hist_t for each terminal and wakeup source, in lat_hists order */
+#define KSTAT_TRACE         2               /* Unread trace_event_t's, reading consumes them */
+#define KSTAT_PROFILE       3               /* profile_sample_t's of the current profiling run */
+#define KSTAT_IRQ           4               /* irq_stat_t for every interrupt/exception vector that has fired */
+#define KSTAT_SYSCALL       5               /* sys_stat_t for every syscall number user programs have made */
+#define KSTAT_STRACE        6               /* Unread strace_rec_t's of traced processes, reading consumes them */
+
+/* Process states reported in procstat_t */
+#define PROC_RUNNING        0               /* Active process of its terminal, runs when the terminal is scheduled */
+#define PROC_SLEEPING       1               /* Waiting on the sleep syscall */
+#define PROC_WAITING        2               /* Waiting for a child process to halt */
+
+#ifndef ASM
+
+/* Snapshot of one PCB */
+typedef struct procstat {
+    int32_t pid;
+    int32_t parent_pid;                     /* -1 for a base shell */
+    int32_t terminal;
+    int32_t state;                          /* PROC_RUNNING, PROC_SLEEPING or PROC_WAITING */
+    int32_t nice;
+    uint32_t utime_ms;                      /* CPU time spent running user code */
+    uint32_t stime_ms;                      /* CPU time spent in the kernel on the process' behalf */
+    uint32_t mem_bytes;                     /* Program image + kernel stack + vidmap page */
+    uint32_t open_fds;                      /* fds in use, including stdin/stdout */
+    char name[MAX_FILE_NAME_LENGTH + 1];    /* Name of the executable */
+} procstat_t;
+
+/* Fills buf with as many stats of the given kind as fit in nbytes, returns how many were written */
+extern int32_t kstat_read(int32_t which, void* buf, int32_t nbytes);
+
+#endif /* _KSTAT_H */
+
+#endif /* ASM */
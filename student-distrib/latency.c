@@ -0,0 +1,75 @@
+/* latency.c - Wakeup to run latency histograms
+ * vim:ts=4 noexpandtab
+ */
+
+#include "latency.h"
+#include "lib.h"
+#include "clock.h"
+
+lat_hist_t lat_hists[TERMINAL_COUNT][LAT_SOURCES];
+
+/* Wait state and wakeup time of each terminal's wait on each source */
+static volatile uint32_t lat_state[TERMINAL_COUNT][LAT_SOURCES];
+static uint64_t lat_stamp[TERMINAL_COUNT][LAT_SOURCES];
+
+/* latency_wait
+ * 
+ * Inputs: terminal - terminal of the waiting process
+ *         source - LAT_* source it is about to wait on
+ * Outputs: None
+ */
+void latency_wait(int32_t terminal, int32_t source) {
+    lat_state[terminal][source] = LAT_ARMED;
+}
+
+/* latency_wake
+ * 
+ * Stamps the wakeup, only the first wakeup of a wait counts
+ * Inputs: terminal - terminal of the process being woken
+ *         source - LAT_* source doing the waking
+ * Outputs: None
+ */
+void latency_wake(int32_t terminal, int32_t source) {
+    if (lat_state[terminal][source] != LAT_ARMED) return;
+
+    lat_stamp[terminal][source] = clock_ns();
+    lat_state[terminal][source] = LAT_WOKEN;
+}
+
+/* latency_run
+ * 
+ * Inputs: terminal - terminal of the process that is running again
+ *         source - LAT_* source it was waiting on
+ * Outputs: None
+ */
+void latency_run(int32_t terminal, int32_t source) {
+    uint32_t flags;
+    uint64_t delta;
+    uint32_t us, bucket;
+    lat_hist_t* hist;
+
+    cli_and_save(flags);
+
+    /* Didn't actually wait (the event was already pending) */
+    if (lat_state[terminal][source] != LAT_WOKEN) {
+        lat_state[terminal][source] = LAT_IDLE;
+        restore_flags(flags);
+        return;
+    }
+    lat_state[terminal][source] = LAT_IDLE;
+
+    delta = clock_ns() - lat_stamp[terminal][source];
+    div64_32(&delta, NS_PER_MS / US_PER_MS);
+    us = (delta >> 32) ? 0xFFFFFFFF : (uint32_t)delta;
+
+    /* log2 bucket */
+    for (bucket = 0; bucket < LAT_BUCKETS - 1 && (us >> (bucket + 1)); bucket++);
+
+    hist = &lat_hists[terminal][source];
+    hist->count++;
+    hist->total_us += us;
+    if (us > hist->max_us) hist->max_us = us;
+    hist->buckets[bucket]++;
+
+    restore_flags(flags);
+}
@@ -0,0 +1,49 @@
+/* latency.h - Wakeup to run latency histograms
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#include "types.h"
+#include "scheduler.h"
+
+/* What woke the process up */
+#define LAT_KEYBOARD        0               /* Enter pressed while terminal_read was waiting */
+#define LAT_RTC             1               /* Virtual RTC tick while rtc_read was waiting */
+#define LAT_SLEEP           2               /* Sleep timer expired */
+#define LAT_SOURCES         3
+
+/* Bucket i counts latencies in [2^i, 2^(i+1)) us, bucket 0 also counts anything under 1 us */
+#define LAT_BUCKETS         32
+
+/* Per terminal, per source state of the wait being measured */
+#define LAT_IDLE            0               /* Nobody is waiting */
+#define LAT_ARMED           1               /* A process is waiting, nothing has woken it yet */
+#define LAT_WOKEN           2               /* Woken at stamp, hasn't run yet */
+
+#ifndef ASM
+
+/* One histogram, returned as is by KSTAT_LATENCY */
+typedef struct lat_hist {
+    uint32_t count;                         /* Wakeups measured */
+    uint32_t total_us;                      /* Sum of all latencies (wraps after ~71 minutes) */
+    uint32_t max_us;                        /* Worst latency seen */
+    uint32_t buckets[LAT_BUCKETS];
+} lat_hist_t;
+
+/* Histograms indexed by [terminal][source] */
+extern lat_hist_t lat_hists[TERMINAL_COUNT][LAT_SOURCES];
+
+/* Called by a process about to wait on source in its terminal */
+extern void latency_wait(int32_t terminal, int32_t source);
+
+/* Called by whatever wakes the waiting process up, usually an interrupt handler */
+extern void latency_wake(int32_t terminal, int32_t source);
+
+/* Called by the woken process once it runs again, records the latency if it was woken */
+extern void latency_run(int32_t terminal, int32_t source);
+
+#endif /* _LATENCY_H */
+
+#endif /* ASM */
@@ -3,37 +3,79 @@
 
 #include "lib.h"
 #include "terminal.h"
+#include "paging.h"
 
-#define NUM_COLS    80
-#define NUM_ROWS    25
 #define ATTRIB      0x0C
+#define BLANK       ((ATTRIB << 8) | ' ')
 
-static int screen_x;
-static int screen_y;
-static char* video_mem = (char *)VIDEO;
+/* A blank cell in the console's current colors, what erasing and scrolling fill with */
+#define CON_BLANK(c)    (((c)->attr << 8) | ' ')
+
+/* VGA color of each ANSI color (the two swap red and blue) */
+static const uint8_t ansi_vga[8] = {0, 4, 2, 6, 1, 5, 3, 7};
+
+/* Text of every terminal, putc/putbuf write to con and console_flush copies it to video memory */
+console_t consoles[TERMINAL_COUNT];
+static console_t* con = &consoles[0];
+
+/* Cursor position last written to the CRTC, -1 if unknown */
+static int32_t cursor_pos = -1;
+
+/* Consoles scroll by moving down through their terminal's vmem (console_t.vga_top) instead
+ * of redrawing, this many rows fit before they have to go back to the top */
+#define VGA_ROWS_MAX        (TERM_VMEM_SIZE / (NUM_COLS << 1))
 
 int terminal_x; // our x value of where our terminal starts when asking for user input
-int cursor_change; // whenever cursor get's updated, we check if we're allowed to update using this flag
 
-static void scroll_up();
-static void current_row(uint8_t *buf, int row_num);
+static void console_putc(console_t* c, uint8_t ch);
+static void console_reset(console_t* c);
+static void console_ansi(console_t* c, uint8_t ch);
+static void console_esc(console_t* c, uint8_t ch);
+static void console_csi(console_t* c, uint8_t ch);
+static void console_sgr(console_t* c);
+static void line_feed(console_t* c);
+static void scroll_region(console_t* c, int32_t top, int32_t bottom, int32_t n);
+static void erase_cells(console_t* c, int32_t y, int32_t from, int32_t to);
+static void move_to(console_t* c, int32_t x, int32_t y);
+static void scroll_up(console_t* c);
+static void set_screen_start(void);
+static int32_t term_vidmapped(int32_t terminal);
+static void draw_view(int32_t terminal);
+
+/* static uint16_t* con_row(console_t* c, int32_t y)
+ * Inputs: c - console, y - screen row
+ * Return Value: pointer to the cells of screen row y
+ * Function: Maps a screen row to its row in the ring */
+static inline uint16_t* con_row(console_t* c, int32_t y) {
+    int32_t r = c->top + y;
+    if (r >= NUM_ROWS) r -= NUM_ROWS;
+    return c->cells[r];
+}
 
 /* void clear(void);
  * Inputs: void
  * Return Value: none
- * Function: Clears video memory */
+ * Function: Clears the current console */
 void clear(void) {
+    console_clear(con - consoles);
+}
+
+/* void console_clear(int32_t terminal);
+ * Inputs: terminal - terminal whose console to clear
+ * Return Value: none
+ * Function: Blanks the console and puts its cursor at the top left */
+void console_clear(int32_t terminal) {
     uint32_t flags;
+    console_t* c = &consoles[terminal];
     cli_and_save(flags);
-    int32_t i;
-    for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
-        *(uint8_t *)(video_mem + (i << 1)) = ' ';
-        *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
-    }
+    memset_word(c->cells, CON_BLANK(c), NUM_ROWS * NUM_COLS);
+    c->top = 0;
+    c->scrolled = 0;
     // put cursor back to start
-    screen_x = 0;
-    screen_y = 0;
-    update_cursor(screen_x, screen_y);
+    c->x = 0;
+    c->y = 0;
+    c->dirty = CON_ALL_ROWS;
+    console_flush(terminal);
     restore_flags(flags);
 }
 
@@ -50,6 +92,47 @@ int32_t pow(int32_t base, int32_t exp) {
     return ret;
 }
 
+/* uint32_t div64_32
+ * Inputs: n - 64-bit dividend, overwritten with the quotient
+ *         base - 32-bit divisor
+ * Return Value: remainder
+ * Function: 64 by 32 bit division without libgcc, same idea as Linux's do_div */
+uint32_t div64_32(uint64_t* n, uint32_t base) {
+    uint32_t high = (uint32_t)(*n >> 32);
+    uint32_t low = (uint32_t)*n;
+    uint32_t q_high = 0;
+    uint32_t rem;
+
+    /* Divide the high half first so the divl below can't overflow */
+    if (high >= base) {
+        q_high = high / base;
+        high = high % base;
+    }
+
+    asm volatile ("divl %4"
+            : "=a"(low), "=d"(rem)
+            : "0"(low), "1"(high), "rm"(base)
+    );
+
+    *n = ((uint64_t)q_high << 32) | low;
+    return rem;
+}
+
+/* uint64_t mul_u64_u32_shr
+ * Inputs: a - 64-bit value
+ *         mul - 32-bit multiplier
+ *         shift - right shift applied to the product (0 to 32)
+ * Return Value: (a * mul) >> shift
+ * Function: Fixed point scaling without a 96-bit intermediate, used for TSC conversions */
+uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mul, uint32_t shift) {
+    uint32_t high = (uint32_t)(a >> 32);
+    uint32_t low = (uint32_t)a;
+    uint64_t ret = ((uint64_t)low * mul) >> shift;
+
+    if (high) ret += ((uint64_t)high * mul) << (32 - shift);
+    return ret;
+}
+
 /* Standard printf().
  * Only supports the following format strings:
  * %%  - print a literal '%' character
@@ -181,74 +264,582 @@ format_char_switch:
  *   Return Value: Number of bytes written
  *    Function: Output a string to the console */
 int32_t puts(int8_t* s) {
-    register int32_t index = 0;
-    while (s[index] != '\0') {
-        putc(s[index]);
-        index++;
-    }
-    return index;
+    uint32_t flags;
+    int32_t n;
+    cli_and_save(flags);
+    n = putbuf((const uint8_t*)s, strlen(s));
+    console_flush(con - consoles);
+    restore_flags(flags);
+    return n;
 }
 
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
- *  Function: Output a character to the console */
+ *  Function: Output a character to the console and show it right away */
 void putc(uint8_t c) {
     uint32_t flags;
     cli_and_save(flags);
+    console_putc(con, c);
+    console_flush(con - consoles);
+    restore_flags(flags);
+}
 
-    if(c == '\n' || c == '\r') {
-        screen_y++;
-        screen_x = 0;
-        terminal_x = 0;
-        /* check if we need to scroll */
-        if (screen_y == NUM_ROWS) {
-            scroll_up();
-            screen_y--;
-        }
-        update_cursor(screen_x, screen_y);
+/* int32_t putbuf(const uint8_t* buf, int32_t n);
+ * Inputs: const uint8_t* buf = characters to print, NUL bytes are skipped
+ *                  int32_t n = number of bytes in buf
+ * Return Value: n
+ * Function: Output a buffer to the console, same as calling putc on each byte except
+ * that escape sequences (see console_csi) are run instead of printed.
+ *
+ * Only the console's rows in RAM are written, in one critical section. Video memory
+ * and the cursor catch up on the next scheduler tick (console_flush_all), or when the
+ * terminal is shown again, so a program printing in a loop costs at most one screen
+ * copy per tick. */
+int32_t putbuf(const uint8_t* buf, int32_t n) {
+    return console_write(con - consoles, buf, n);
+}
+
+/* int32_t console_write(int32_t terminal, const uint8_t* buf, int32_t n);
+ * Inputs: terminal - terminal whose console to write to
+ *         buf, n - same as putbuf
+ * Return Value: n
+ * Function: putbuf for any terminal's console, not just the current one */
+int32_t console_write(int32_t terminal, const uint8_t* buf, int32_t n) {
+    uint32_t flags;
+    int32_t i;
+    console_t* c = &consoles[terminal];
+    cli_and_save(flags);
+    for (i = 0; i < n; i++) {
+        /* Plain text skips the escape sequence parser */
+        if (c->ansi.state == ANSI_GROUND && buf[i] != ANSI_ESC) console_putc(c, buf[i]);
+        else console_ansi(c, buf[i]);
+    }
+    restore_flags(flags);
+    return n;
+}
+
+/* static void console_putc(console_t* c, uint8_t ch);
+ * Inputs: c - console to write to
+ *         ch - character to write, NUL is ignored
+ * Return Value: void
+ * Function: Writes a character into the console's rows and moves its cursor, interrupts must be off */
+static void console_putc(console_t* c, uint8_t ch) {
+    switch (ch) {
+        case '\0':
+            return;
+        case '\n':
+            terminal_x = 0;
+            break;
+        case '\r':
+            terminal_x = 0;
+            c->x = 0;
+            return;
+        case '\b':
+            /* only erase what was typed/written on this line */
+            if (!terminal_x || (c->x == 0 && c->y == 0)) return;
+            terminal_x--;
+            if (c->x-- == 0) {
+                c->x = NUM_COLS - 1;
+                c->y--;
+            }
+            con_row(c, c->y)[c->x] = CON_BLANK(c);
+            c->dirty |= 1 << c->y;
+            return;
+        default:
+            con_row(c, c->y)[c->x] = (c->attr << 8) | ch;
+            c->dirty |= 1 << c->y;
+            terminal_x++;
+            if (++c->x < NUM_COLS) return;
+            break;
+    }
+
+    /* newline or wrap */
+    c->x = 0;
+    line_feed(c);
+}
+
+/* void console_init(void);
+ * Inputs: void
+ * Return Value: void
+ * Function: Sets every console to its power on state, called before anything is printed */
+void console_init(void) {
+    int32_t terminal;
+    for (terminal = 0; terminal < TERMINAL_COUNT; terminal++)
+        console_reset(&consoles[terminal]);
+}
+
+/* static void console_reset(console_t* c);
+ * Inputs: c - console to reset
+ * Return Value: void
+ * Function: Default colors, no scroll region, cursor shown at the top left of a blank screen */
+static void console_reset(console_t* c) {
+    c->fg = ATTRIB & 0x0F;
+    c->bg = ATTRIB >> 4;
+    c->bold = 0;
+    c->reverse = 0;
+    c->attr = ATTRIB;
+    c->margin_top = 0;
+    c->margin_bottom = NUM_ROWS - 1;
+    c->saved_x = c->saved_y = 0;
+    c->cursor_hidden = 0;
+    c->ansi.state = ANSI_GROUND;
+    memset_word(c->cells, BLANK, NUM_ROWS * NUM_COLS);
+    c->x = c->y = 0;
+    c->dirty = CON_ALL_ROWS;
+}
+
+/* static void console_ansi(console_t* c, uint8_t ch);
+ * Inputs: c - console to write to
+ *         ch - ESC or the next byte of an escape sequence
+ * Return Value: void
+ * Function: Runs the byte through the console's escape sequence parser and does what
+ *           the sequence says once it is complete, interrupts must be off */
+static void console_ansi(console_t* c, uint8_t ch) {
+    switch (ansi_step(&c->ansi, ch)) {
+        case ANSI_PUT:
+            console_putc(c, ch);
+            break;
+        case ANSI_CSI:
+            console_csi(c, ch);
+            break;
+        case ANSI_ESC_FINAL:
+            console_esc(c, ch);
+            break;
+    }
+}
+
+/* static void console_esc(console_t* c, uint8_t ch);
+ * Inputs: c - console, ch - final byte of an ESC x sequence
+ * Return Value: void
+ * Function: ESC 7/8 save/restore the cursor, ESC D/E/M index, next line and reverse
+ *           index, ESC c resets the console. Anything else is ignored */
+static void console_esc(console_t* c, uint8_t ch) {
+    switch (ch) {
+        case '7':
+            c->saved_x = c->x;
+            c->saved_y = c->y;
+            break;
+        case '8':
+            move_to(c, c->saved_x, c->saved_y);
+            break;
+        case 'E':
+            c->x = 0;
+            /* fall through */
+        case 'D':
+            line_feed(c);
+            break;
+        case 'M':
+            if (c->y == c->margin_top) scroll_region(c, c->margin_top, c->margin_bottom, -1);
+            else if (c->y > 0) c->y--;
+            break;
+        case 'c':
+            console_reset(c);
+            terminal_x = 0;
+            break;
+    }
+}
+
+/* static void console_csi(console_t* c, uint8_t ch);
+ * Inputs: c - console, ch - final byte of an ESC [ sequence, the params are in c->ansi
+ * Return Value: void
+ * Function: Cursor movement (A-H, a, d, e, f, `, s, u), erasing (J, K, X), inserting
+ *           and deleting (@, P, L, M), scrolling (S, T, r), colors (m) and showing
+ *           or hiding the cursor (?25h/l). Anything else is ignored */
+static void console_csi(console_t* c, uint8_t ch) {
+    ansi_t* p = &c->ansi;
+    int32_t n = ansi_param(p, 0, 1);
+    uint16_t* row = con_row(c, c->y);
+    int32_t y;
+
+    if (p->priv) {
+        if (p->priv == '?' && ansi_param(p, 0, 0) == 25 && (ch == 'h' || ch == 'l'))
+            c->cursor_hidden = (ch == 'l');
+        return;
+    }
+
+    switch (ch) {
+        case 'A': move_to(c, c->x, c->y - n); break;
+        case 'B':
+        case 'e': move_to(c, c->x, c->y + n); break;
+        case 'C':
+        case 'a': move_to(c, c->x + n, c->y); break;
+        case 'D': move_to(c, c->x - n, c->y); break;
+        case 'E': move_to(c, 0, c->y + n); break;
+        case 'F': move_to(c, 0, c->y - n); break;
+        case 'G':
+        case '`': move_to(c, n - 1, c->y); break;
+        case 'd': move_to(c, c->x, n - 1); break;
+        case 'H':
+        case 'f': move_to(c, ansi_param(p, 1, 1) - 1, n - 1); break;
+        case 's':
+            c->saved_x = c->x;
+            c->saved_y = c->y;
+            break;
+        case 'u': move_to(c, c->saved_x, c->saved_y); break;
+
+        case 'J':
+            /* 0: cursor to the end, 1: start to the cursor, 2/3: everything */
+            switch (ansi_param(p, 0, 0)) {
+                case 0:
+                    erase_cells(c, c->y, c->x, NUM_COLS);
+                    for (y = c->y + 1; y < NUM_ROWS; y++) erase_cells(c, y, 0, NUM_COLS);
+                    break;
+                case 1:
+                    for (y = 0; y < c->y; y++) erase_cells(c, y, 0, NUM_COLS);
+                    erase_cells(c, c->y, 0, c->x + 1);
+                    break;
+                default:
+                    for (y = 0; y < NUM_ROWS; y++) erase_cells(c, y, 0, NUM_COLS);
+                    break;
+            }
+            break;
+        case 'K':
+            switch (ansi_param(p, 0, 0)) {
+                case 0: erase_cells(c, c->y, c->x, NUM_COLS); break;
+                case 1: erase_cells(c, c->y, 0, c->x + 1); break;
+                default: erase_cells(c, c->y, 0, NUM_COLS); break;
+            }
+            break;
+        case 'X': erase_cells(c, c->y, c->x, c->x + n); break;
+
+        case '@':
+            if (n > NUM_COLS - c->x) n = NUM_COLS - c->x;
+            memmove(row + c->x + n, row + c->x, (NUM_COLS - c->x - n) << 1);
+            erase_cells(c, c->y, c->x, c->x + n);
+            break;
+        case 'P':
+            if (n > NUM_COLS - c->x) n = NUM_COLS - c->x;
+            memmove(row + c->x, row + c->x + n, (NUM_COLS - c->x - n) << 1);
+            erase_cells(c, c->y, NUM_COLS - n, NUM_COLS);
+            break;
+        case 'L':
+        case 'M':
+            /* Only inside the scroll region, the rows below the cursor move */
+            if (c->y < c->margin_top || c->y > c->margin_bottom) break;
+            scroll_region(c, c->y, c->margin_bottom, ch == 'M' ? n : -n);
+            c->x = 0;
+            break;
+        case 'S': scroll_region(c, c->margin_top, c->margin_bottom, n); break;
+        case 'T': scroll_region(c, c->margin_top, c->margin_bottom, -n); break;
+        case 'r':
+            y = ansi_param(p, 1, NUM_ROWS);
+            if (n < y && y <= NUM_ROWS) {
+                c->margin_top = n - 1;
+                c->margin_bottom = y - 1;
+                move_to(c, 0, 0);
+            }
+            break;
+
+        case 'm': console_sgr(c); break;
+    }
+}
+
+/* static void console_sgr(console_t* c);
+ * Inputs: c - console whose CSI m sequence just ended
+ * Return Value: void
+ * Function: Sets the colors new text gets. Bold is the bright foreground, bright
+ *           backgrounds are the normal ones since VGA uses that bit for blinking.
+ *           Reverse video loses the intensity bit with it: the old foreground
+ *           becomes a normal background and the old background a dim foreground */
+static void console_sgr(console_t* c) {
+    ansi_t* p = &c->ansi;
+    int32_t i, v, n = p->nparams;
+    uint8_t fg, bg;
+
+    if (n > ANSI_MAX_PARAMS) n = ANSI_MAX_PARAMS;
+    for (i = 0; i < n; i++) {
+        v = p->params[i];
+        if (v == 0) {
+            c->fg = ATTRIB & 0x0F;
+            c->bg = ATTRIB >> 4;
+            c->bold = c->reverse = 0;
+        } else if (v == 1) c->bold = 1;
+        else if (v == 22) c->bold = 0;
+        else if (v == 7) c->reverse = 1;
+        else if (v == 27) c->reverse = 0;
+        else if (v >= 30 && v <= 37) c->fg = ansi_vga[v - 30];
+        else if (v == 39) c->fg = ATTRIB & 0x0F;
+        else if (v >= 40 && v <= 47) c->bg = ansi_vga[v - 40];
+        else if (v == 49) c->bg = ATTRIB >> 4;
+        else if (v >= 90 && v <= 97) c->fg = ansi_vga[v - 90] | 0x08;
+        else if (v >= 100 && v <= 107) c->bg = ansi_vga[v - 100];
+    }
+
+    fg = c->fg | (c->bold ? 0x08 : 0);
+    bg = c->bg & 0x07;
+    c->attr = c->reverse ? (((fg & 0x07) << 4) | bg) : ((bg << 4) | fg);
+}
+
+/* static void line_feed(console_t* c);
+ * Inputs: c - console
+ * Return Value: void
+ * Function: Moves the cursor down a row, scrolling the scroll region if it is on its
+ *           bottom row. Below the region the cursor just stops at the last row */
+static void line_feed(console_t* c) {
+    if (c->y == c->margin_bottom) scroll_region(c, c->margin_top, c->margin_bottom, 1);
+    else if (c->y < NUM_ROWS - 1) c->y++;
+}
+
+/* static void scroll_region(console_t* c, int32_t top, int32_t bottom, int32_t n);
+ * Inputs: c - console
+ *         top, bottom - first and last row to scroll
+ *         n - rows to scroll up by, negative to scroll down
+ * Return Value: void
+ * Function: The whole screen scrolling up goes through scroll_up so it still feeds the
+ *           scrollback and scrolls in hardware, anything else moves the rows' cells */
+static void scroll_region(console_t* c, int32_t top, int32_t bottom, int32_t n) {
+    int32_t rows = bottom - top + 1;
+    int32_t y;
+
+    if (n > rows) n = rows;
+    if (n < -rows) n = -rows;
+
+    if (n > 0 && top == 0 && bottom == NUM_ROWS - 1) {
+        while (n--) scroll_up(c);
+        return;
+    }
+
+    if (n > 0) {
+        for (y = top; y <= bottom - n; y++)
+            memcpy(con_row(c, y), con_row(c, y + n), NUM_COLS << 1);
+        for (; y <= bottom; y++)
+            memset_word(con_row(c, y), CON_BLANK(c), NUM_COLS);
+    } else if (n < 0) {
+        for (y = bottom; y >= top - n; y--)
+            memcpy(con_row(c, y), con_row(c, y + n), NUM_COLS << 1);
+        for (; y >= top; y--)
+            memset_word(con_row(c, y), CON_BLANK(c), NUM_COLS);
+    }
+    c->dirty |= ((1 << (bottom + 1)) - 1) & ~((1 << top) - 1);
+}
+
+/* static void erase_cells(console_t* c, int32_t y, int32_t from, int32_t to);
+ * Inputs: c - console
+ *         y - screen row
+ *         from, to - columns to blank, to is one past the last one
+ * Return Value: void
+ * Function: Blanks part of a row */
+static void erase_cells(console_t* c, int32_t y, int32_t from, int32_t to) {
+    if (to > NUM_COLS) to = NUM_COLS;
+    if (from >= to) return;
+    memset_word(con_row(c, y) + from, CON_BLANK(c), to - from);
+    c->dirty |= 1 << y;
+}
+
+/* static void move_to(console_t* c, int32_t x, int32_t y);
+ * Inputs: c - console
+ *         x, y - where to put the cursor, clamped to the screen
+ * Return Value: void
+ * Function: Moves the cursor. Backspace can't erase past it anymore since whatever is
+ *           left of it wasn't typed on this line */
+static void move_to(console_t* c, int32_t x, int32_t y) {
+    if (x < 0) x = 0;
+    if (x >= NUM_COLS) x = NUM_COLS - 1;
+    if (y < 0) y = 0;
+    if (y >= NUM_ROWS) y = NUM_ROWS - 1;
+    c->x = x;
+    c->y = y;
+    terminal_x = 0;
+}
+
+/* void console_flush(int32_t terminal);
+ * Inputs: terminal - terminal whose console to show
+ * Return Value: void
+ * Function: Copies the console's changed rows to the terminal's vmem and, if it is the
+ *           shown terminal, moves the screen's cursor.
+ *
+ *           If the console scrolled, it moves down through the vmem by as many rows so only
+ *           the new rows are copied (for the shown terminal the VGA start address follows).
+ *           When it would run off the end it goes back to the top and the whole console is
+ *           copied once. */
+void console_flush(int32_t terminal) {
+    uint32_t flags;
+    console_t* c = &consoles[terminal];
+    uint16_t* vmem;
+    int32_t y;
+
+    cli_and_save(flags);
+
+    /* Scrolled back, the console catches up once the view goes back to it */
+    if (c->view) {
+        if (c->view_stale) draw_view(terminal);
         restore_flags(flags);
         return;
     }
 
-    
-    /* output to screen */
-    if (c == '\b'){
-        if (terminal_x) {
-            screen_x--;
-            terminal_x--;
-            *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1)) = 0;
+    if (c->scrolled) {
+        /* vidmap programs draw into the top of the vmem, so those consoles stay there */
+        if (c->scrolled >= NUM_ROWS || term_vidmapped(terminal)) {
+            c->dirty = CON_ALL_ROWS;
+        } else if (c->vga_top + c->scrolled + NUM_ROWS <= VGA_ROWS_MAX) {
+            c->vga_top += c->scrolled;
+        } else {
+            c->vga_top = 0;
+            c->dirty = CON_ALL_ROWS;
         }
-    } else {
-        *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1)) = c;
-        screen_x++;  
-        terminal_x++;
+        c->scrolled = 0;
+        if (terminal == terminal_shown) set_screen_start();
     }
 
+    vmem = (uint16_t*)get_term_vmem(terminal) + c->vga_top * NUM_COLS;
+    for (y = 0; c->dirty && y < NUM_ROWS; y++) {
+        if (!(c->dirty & (1 << y))) continue;
+        memcpy(vmem + y * NUM_COLS, con_row(c, y), NUM_COLS << 1);
+        c->dirty &= ~(1 << y);
+    }
 
-    /* check for bounds */
-    if (screen_x == NUM_COLS) {
-        screen_y++;
-        screen_x = 0;
-        /* check if we need to scroll */
-        if (screen_y == NUM_ROWS) {
-            scroll_up();
-            screen_y--;
-        }
-    } else if (screen_x < 0) {
-        screen_x = NUM_COLS - 1;
-        screen_y--;
+    if (terminal == terminal_shown) update_cursor(c->x, c->cursor_hidden ? NUM_ROWS : c->y);
+    restore_flags(flags);
+}
+
+/* void console_park(int32_t terminal);
+ * Inputs: terminal - terminal whose console to move
+ * Return Value: void
+ * Function: Moves the console back to the top of its terminal's vmem, where vidmap
+ *           programs expect the screen to be */
+void console_park(int32_t terminal) {
+    uint32_t flags;
+    console_t* c = &consoles[terminal];
+
+    cli_and_save(flags);
+    if (c->vga_top != 0) {
+        c->vga_top = 0;
+        c->dirty = CON_ALL_ROWS;
+        if (terminal == terminal_shown) set_screen_start();
+        console_flush(terminal);
     }
+    restore_flags(flags);
+}
+
+/* void console_show(int32_t terminal);
+ * Inputs: terminal - terminal that was just made the shown terminal
+ * Return Value: void
+ * Function: Points the screen at the terminal's vmem and copies the rows that changed
+ *           while it wasn't shown, the rest are still in its vmem from last time */
+void console_show(int32_t terminal) {
+    uint32_t flags;
 
+    cli_and_save(flags);
+    set_screen_start();
+    console_flush(terminal);
+    restore_flags(flags);
+}
+
+/* void console_view_scroll(int32_t terminal, int32_t lines);
+ * Inputs: terminal - terminal to scroll the view of
+ *         lines - lines to go back by (negative to go forward)
+ * Return Value: void
+ * Function: Shows older lines from the terminal's scrollback. Output keeps going
+ *           to the console meanwhile, the view stays on the same lines */
+void console_view_scroll(int32_t terminal, int32_t lines) {
+    uint32_t flags;
+    console_t* c = &consoles[terminal];
+    int32_t view;
+
+    cli_and_save(flags);
+
+    /* vidmap programs draw over the console, don't draw over them */
+    if (term_vidmapped(terminal)) {
+        restore_flags(flags);
+        return;
+    }
+
+    view = c->view + lines;
+    if (view > scrollback_count(&terminal_ctx[terminal].scrollback))
+        view = scrollback_count(&terminal_ctx[terminal].scrollback);
+    if (view <= 0) {
+        console_view_reset(terminal);
+    } else if (view != c->view) {
+        c->view = view;
+        draw_view(terminal);
+    }
+
+    restore_flags(flags);
+}
 
-    *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1) + 1) = ATTRIB;
-    screen_x %= NUM_COLS;
-    screen_y = (screen_y + (screen_x / NUM_COLS)) % NUM_ROWS;
-    update_cursor(screen_x, screen_y);
+/* void console_view_reset(int32_t terminal);
+ * Inputs: terminal - terminal to go back to the console of
+ * Return Value: void
+ * Function: Ends scrollback viewing and draws the console as it is now */
+void console_view_reset(int32_t terminal) {
+    uint32_t flags;
+    console_t* c = &consoles[terminal];
 
+    cli_and_save(flags);
+    if (c->view) {
+        c->view = 0;
+        c->view_stale = 0;
+        c->dirty = CON_ALL_ROWS;
+        console_flush(terminal);
+    }
     restore_flags(flags);
 }
 
+/* static void draw_view(int32_t terminal);
+ * Inputs: terminal - terminal whose view to draw
+ * Return Value: void
+ * Function: Draws view lines of scrollback followed by the top of the console into
+ *           the terminal's vmem, and hides the cursor if the terminal is shown */
+static void draw_view(int32_t terminal) {
+    console_t* c = &consoles[terminal];
+    uint16_t* vmem = (uint16_t*)get_term_vmem(terminal) + c->vga_top * NUM_COLS;
+    int32_t y;
+
+    for (y = 0; y < NUM_ROWS; y++) {
+        if (y < c->view)
+            scrollback_get(&terminal_ctx[terminal].scrollback, c->view - y, vmem + y * NUM_COLS, NUM_COLS, BLANK);
+        else
+            memcpy(vmem + y * NUM_COLS, con_row(c, y - c->view), NUM_COLS << 1);
+    }
+    c->view_stale = 0;
+
+    /* Just below the screen is out of sight */
+    if (terminal == terminal_shown) update_cursor(0, NUM_ROWS);
+}
+
+/* static void set_screen_start(void);
+ * Inputs: void
+ * Return Value: void
+ * Function: Writes the VGA start address registers so the screen shows the shown
+ *           terminal's console */
+static void set_screen_start(void) {
+    uint16_t start = (((uint32_t)get_term_vmem(terminal_shown) - VIDEO) >> 1) + consoles[terminal_shown].vga_top * NUM_COLS;
+
+    outb(0x0C, 0x3D4);
+    outb((uint8_t)((start >> 8) & 0xFF), 0x3D5);
+    outb(0x0D, 0x3D4);
+    outb((uint8_t)(start & 0xFF), 0x3D5);
+
+    /* The cursor is relative to video memory, not to the start address */
+    cursor_pos = -1;
+}
+
+/* static int32_t term_vidmapped(int32_t terminal);
+ * Inputs: terminal - terminal to check
+ * Return Value: 1 if a process of the terminal has video memory mapped, 0 otherwise
+ * Function: Those processes draw into the first page of the terminal's vmem, so its
+ *           console has to stay there */
+static int32_t term_vidmapped(int32_t terminal) {
+    int32_t pid;
+
+    /* pcbs aren't set up yet while the kernel prints its boot messages */
+    for (pid = 0; pid < PID_NUM; pid++)
+        if (pcbs[pid] && pcbs[pid]->in_use && pcbs[pid]->vidmap && pcbs[pid]->terminal == terminal) return 1;
+    return 0;
+}
+
+/* void console_flush_all(void);
+ * Inputs: void
+ * Return Value: void
+ * Function: Flushes the shown console, called once per scheduler tick. Consoles that
+ *           aren't shown just keep collecting dirty rows (and scrolled rows) until
+ *           console_show, so a busy background terminal costs nothing per tick and
+ *           switching to it copies only the rows that changed since it was last shown */
+void console_flush_all(void) {
+    console_flush(terminal_shown);
+}
+
 /* int8_t* itoa(uint32_t value, int8_t* buf, int32_t radix);
  * Inputs: uint32_t value = number to convert
  *            int8_t* buf = allocated buffer to place string in
@@ -540,7 +1131,7 @@ int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
 void test_interrupts(void) {
     int32_t i;
     for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
-        video_mem[i << 1]++;
+        ((char*)VIDEO)[i << 1]++;
     }
 }
 
@@ -553,15 +1144,16 @@ void test_interrupts(void) {
 */
 void update_cursor(int x, int y)
 {
-    /* We should only be updating cursor in the shown terminal */
-    if (cursor_change) {
-        uint16_t pos = y * NUM_COLS + x;
+    uint16_t pos = (((uint32_t)get_term_vmem(terminal_shown) - VIDEO) >> 1) + (consoles[terminal_shown].vga_top + y) * NUM_COLS + x;
+
+    /* The CRTC is slow to talk to, skip it if the cursor hasn't moved */
+    if (pos == cursor_pos) return;
+    cursor_pos = pos;
  
-        outb(0x0F, 0x3D4);
-        outb((uint8_t)(pos & 0xFF), 0x3D5);
-        outb(0x0E, 0x3D4);
-        outb((uint8_t)((pos >> 8) & 0xFF), 0x3D5);
-    }
+    outb(0x0F, 0x3D4);
+    outb((uint8_t)(pos & 0xFF), 0x3D5);
+    outb(0x0E, 0x3D4);
+    outb((uint8_t)((pos >> 8) & 0xFF), 0x3D5);
 }
 
 /* switch_screen
@@ -571,19 +1163,11 @@ void update_cursor(int x, int y)
  * 
  * Return Value: void
  * 
- * Function: Switches screen coords to match new terminal number
- * and updates vmem to new backing terminal vmem or main screen
+ * Function: Switches the console putc/putbuf write to over to
+ * the new terminal, along with its line editing state
  *
  * */
 void switch_screen(int32_t old_term, int32_t curr_term, int32_t cursor) {
-    /* Save old screen */
-    terminal_ctx[old_term].screen_x = screen_x;
-    terminal_ctx[old_term].screen_y = screen_y;
-
-    /* Get new screen */
-    screen_x = terminal_ctx[curr_term].screen_x;
-    screen_y = terminal_ctx[curr_term].screen_y;
-
     /* Update vmem */
     terminal_ctx[old_term].terminal_x = terminal_x;
     terminal_x = terminal_ctx[curr_term].terminal_x;
@@ -595,80 +1179,35 @@ void switch_screen(int32_t old_term, int32_t curr_term, int32_t cursor) {
     terminal_ctx[old_term].top_scommands_idx = top_scommands_idx;
     top_scommands_idx = terminal_ctx[curr_term].top_scommands_idx;
 
-    /* If TS == curr_term, display main screen and allow cursor updates */
-    if (terminal_shown == curr_term) {
-        cursor_change = 1;
-        video_mem = (char *)VIDEO;
-    }
-    /* Else, switch to backing term vmem and don't allow cursor updates */
-    else {
-        cursor_change = 0;
-        video_mem = (char *)get_term_vmem(curr_term);
-    }
+    /* Get new screen */
+    con = &consoles[curr_term];
 
     /* Update cursor */
-    if (cursor) update_cursor(screen_x, screen_y);
+    if (cursor && terminal_shown == curr_term) update_cursor(con->x, con->cursor_hidden ? NUM_ROWS : con->y);
 }
 
-/* static void scroll_up()
- * Inputs: void
+/* static void scroll_up(console_t* c)
+ * Inputs: c - console to scroll
  * Return Value: void
- * Function: writes to the terminal/video memory 
+ * Function: writes to the terminal's console
  * 
- * This function scrolls our screen up.
+ * This function scrolls the console up by one row. The rows are a ring, so the old top
+ * row just becomes the new (blank) bottom row once it is copied to the scrollback. The dirty bits move up with the rows,
+ * console_flush decides whether the screen can scroll in hardware or needs a redraw.
  * 
  * */
-static void scroll_up() {
-
-    int i;
-    int curr_row;
-    int prev_row;
-    uint8_t row_buf[NUM_COLS * 2]; // each character holds char in the first byte and color in second byte
-    uint8_t* addr = (uint8_t*)video_mem;
-    
-    for (curr_row = 1; curr_row < NUM_ROWS; curr_row++) {
-      /* we get our current row and copy it to the previous row*/
-      prev_row = curr_row - 1;
-      /* get our current row buffer */
-      current_row(row_buf, curr_row);
-      
-      /* offset video memory to the previous row */
-      addr = (uint8_t*)video_mem + ((prev_row * NUM_COLS) << 1);
-
-      /* copy contents of row_buf to previous row in video memory*/
-      memcpy(addr, row_buf, (NUM_COLS << 1));  
+static void scroll_up(console_t* c) {
+    scrollback_t* sb = &terminal_ctx[c - consoles].scrollback;
+
+    /* Keep the row that goes off the top, a view stays on the lines it was showing */
+    scrollback_push(sb, c->cells[c->top], NUM_COLS, BLANK);
+    if (c->view && ++c->view > scrollback_count(sb)) {
+        c->view = scrollback_count(sb);
+        c->view_stale = 1;
     }
 
-    /* clear the lowest row */
-    addr = (uint8_t*)video_mem + (((NUM_ROWS - 1) * NUM_COLS) << 1);
-    
-    for (i = 0; i < NUM_COLS; i++) {
-        *(uint8_t *)(addr + (i << 1)) = 0;
-        *(uint8_t *)(addr + (i << 1) + 1) = ATTRIB;
-    }
-    
-}
-
-/* static void current_row(char* buf, int row_num)
- * Inputs: char* buf, int row_num
- * Return Value: none
- * Function: writes to the terminal/video memory 
- * 
- * This function takes in buf and row_num and copies contents from a specific video memory row at row_num to the buffer
- * 
- * */
-static void current_row(uint8_t* buf, int row_num) {
-
-    int i;
-    uint8_t* addr;
-    uint8_t* dest = buf;
-
-    /* offset the video memory to get proper row */
-    addr = (uint8_t*)video_mem + ((NUM_COLS * row_num) << 1);
-    
-    /* copy contents of vid memory into buf*/
-    for (i = 0; i < NUM_COLS; i++) {
-        *(uint8_t *)(dest + (i << 1)) = *(uint8_t *)(addr + (i << 1));
-        *(uint8_t *)(dest + (i << 1) + 1) = *(uint8_t *)(addr + (i << 1) + 1);
-    }
+    if (++c->top == NUM_ROWS) c->top = 0;
+    memset_word(con_row(c, NUM_ROWS - 1), CON_BLANK(c), NUM_COLS);
+    c->dirty = (c->dirty >> 1) | (1 << (NUM_ROWS - 1));
+    c->scrolled++;
 }
@@ -6,6 +6,7 @@
 #define _LIB_H
 
 #include "types.h"
+#include "ansi.h"
 
 /* We need to have paging know where video memory is so we move VIDEO here */
 
@@ -15,12 +16,57 @@
 /* Putting this here so that C doesn't yell at me */
 #define TERMINAL_COUNT  3
 
+/* Size of the text screen */
+#define NUM_COLS    80
+#define NUM_ROWS    25
+
+/* console_t.dirty with every row set */
+#define CON_ALL_ROWS    ((1 << NUM_ROWS) - 1)
+
 #ifndef ASM
 
+/* Text of one terminal's screen, kept in RAM and copied to the terminal's vmem by console_flush */
+typedef struct console {
+    uint16_t cells[NUM_ROWS][NUM_COLS];     /* Ring of rows, screen row 0 is cells[top] */
+    int32_t top;
+    int32_t x;                              /* Cursor column */
+    int32_t y;                              /* Cursor row on screen */
+    uint32_t dirty;                         /* Bit per screen row that video memory doesn't have yet */
+    int32_t scrolled;                       /* Rows scrolled since the last flush */
+    int32_t vga_top;                        /* Row of the terminal's vmem that screen row 0 is drawn at */
+    int32_t view;                           /* Scrollback lines the screen is scrolled back by, 0 shows the console */
+    int32_t view_stale;                     /* The lines being viewed moved, draw them again */
+    int32_t margin_top;                     /* Scroll region, newlines at margin_bottom only scroll these rows */
+    int32_t margin_bottom;
+    int32_t saved_x;                        /* Cursor saved by ESC 7 / CSI s */
+    int32_t saved_y;
+    int32_t cursor_hidden;
+    uint8_t attr;                           /* Attribute new text is written with, from fg/bg/bold/reverse */
+    uint8_t fg;
+    uint8_t bg;
+    uint8_t bold;
+    uint8_t reverse;
+    ansi_t ansi;                            /* Escape sequence putbuf is in the middle of */
+} console_t;
+
+extern console_t consoles[TERMINAL_COUNT];
+
 int32_t pow(int32_t base, int32_t exp);
+uint32_t div64_32(uint64_t* n, uint32_t base);
+uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mul, uint32_t shift);
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
 int32_t puts(int8_t *s);
+int32_t putbuf(const uint8_t* buf, int32_t n);
+int32_t console_write(int32_t terminal, const uint8_t* buf, int32_t n);
+void console_init(void);
+void console_clear(int32_t terminal);
+void console_flush(int32_t terminal);
+void console_flush_all(void);
+void console_park(int32_t terminal);
+void console_show(int32_t terminal);
+void console_view_scroll(int32_t terminal, int32_t lines);
+void console_view_reset(int32_t terminal);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
 uint32_t strlen(const int8_t* s);
@@ -44,7 +90,6 @@ void update_cursor(int x, int y);
 void switch_screen(int32_t old_term, int32_t curr_term, int32_t cursor);
 
 extern int terminal_x;
-extern int cursor_change;
 /* Port read functions */
 /* Inb reads a byte and returns its value as a zero-extended 32-bit
  * unsigned int */
@@ -89,6 +134,15 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the 64-bit time stamp counter */
+static inline uint64_t rdtsc(void) {
+    uint64_t val;
+    asm volatile ("rdtsc"
+            : "=A"(val)
+    );
+    return val;
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
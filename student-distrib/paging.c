@@ -3,6 +3,7 @@
  */
 
 #include "paging.h"
+#include "vdso.h"
 
 /* Initializing paging function 
  *
@@ -25,14 +26,10 @@ void paging_init() {
         first_page_table[i].rw = 1;
     }
 
-    /* Set screen vmem page to be Present, Write Enabled, Supervisor */
-    first_page_table[SCREEN_VMEM_PT].rw = 1;
-    first_page_table[SCREEN_VMEM_PT].present = 1;
-
     /* Set term vmem pages to be Present, Write Enabled, Supervisor */
-    for (i = 0; i < TERMINAL_COUNT; i++) {
-        first_page_table[TERM_VMEM_PT + i].rw = 1;
-        first_page_table[TERM_VMEM_PT + i].present = 1;
+    for (i = 0; i < TERMINAL_COUNT * TERM_VMEM_PAGES; i++) {
+        first_page_table[SCREEN_VMEM_PT + i].rw = 1;
+        first_page_table[SCREEN_VMEM_PT + i].present = 1;
     }
 
     /* Set first page to present, write enabled, supervisor,
@@ -67,6 +64,12 @@ void paging_init() {
     vidmap_page_table[VIDMAP_PT].rw = 1;
     vidmap_page_table[VIDMAP_PT].user = 1;
 
+    /* vdso page is always Present, Read Only, User */
+    vidmap_page_table[VDSO_PT].page_base_addr = ((uint32_t)&vdso_page) >> BASE_ADDR_BITS;
+    vidmap_page_table[VDSO_PT].rw = 0;
+    vidmap_page_table[VDSO_PT].user = 1;
+    vidmap_page_table[VDSO_PT].present = 1;
+
     /* Set up malloc pages */
     for (i = MALLOC_PD_START; i < MALLOC_PD_END; i++) {
         page_directory[i].pt_base_addr = i * BIG_PAGE_SIZE;
@@ -88,21 +91,23 @@ void page_user_program(uint32_t pid) {
     flush_tlb();
 }
 
-/* Copy current terminal vmem to main screen vmem or vice versa 
- * Inputs:  terminal - terminal number indicating which vmem page to use
- *          screen - 1 indicates copy from terminal vmem to screen,
- *                   0 indicates copy from screen to terminal vmem
- * Outputs: None */
-void copy_term_vmem(uint32_t terminal, uint32_t screen) {
-    /* Check if we want to copy from term to main screen vmem */
-    if (screen) memcpy((void*)VIDEO, (void*)((TERM_VMEM_PT + terminal) * PAGE_SIZE), PAGE_SIZE);
-    /* Else we want to copy from screen to term vmem */
-    else memcpy((void*)((TERM_VMEM_PT + terminal) * PAGE_SIZE), (void*)VIDEO, PAGE_SIZE);
+/* Map a 4MB uncached page for memory mapped registers
+ *
+ * Used for the APICs, the page is identity mapped and kernel only */
+void page_mmio(uint32_t pd) {
+    page_directory[pd].pt_base_addr = (pd * BIG_PAGE_SIZE) >> BASE_ADDR_BITS;
+    page_directory[pd].cache = 1;
+    page_directory[pd].write_through = 1;
+    page_directory[pd].size = 1;
+    page_directory[pd].rw = 1;
+    page_directory[pd].present = 1;
+    /* Don't forget to flush... */
+    flush_tlb();
 }
 
-/* Get pointer to terminal vmem */
+/* Get pointer to terminal vmem (the part of text mode video memory the terminal draws into) */
 void* get_term_vmem(uint32_t terminal) {
-    return (void*)((TERM_VMEM_PT + terminal) * PAGE_SIZE);
+    return (void*)(VIDEO + terminal * TERM_VMEM_SIZE);
 }
 
 /* Change vidmap for vmem upon schedule
@@ -110,10 +115,8 @@ void* get_term_vmem(uint32_t terminal) {
  *
  * Outputs: None */
 void change_vidmap(uint32_t terminal) {
-    /* Check if we want to display current vidmap on screen */
-    if (terminal_active == terminal_shown) vidmap_page_table[VIDMAP_PT].page_base_addr = ((uint32_t)VIDEO) >> BASE_ADDR_BITS;
-    /* Else we want to store vidmap in backing terminal vmem */
-    else vidmap_page_table[VIDMAP_PT].page_base_addr = ((uint32_t)get_term_vmem(terminal)) >> BASE_ADDR_BITS;
+    /* Programs draw straight into their terminal's vmem, shown or not */
+    vidmap_page_table[VIDMAP_PT].page_base_addr = ((uint32_t)get_term_vmem(terminal)) >> BASE_ADDR_BITS;
 }
 
 /* Recursive binary tree algorithm used for finding malloc block 
@@ -28,9 +28,12 @@
 #define VMEM_PD             0
 #define KERNEL_PD           1
 
-/* Page tables associated with screen vmem and backing terminal vmem within first_page_table */
+/* Page tables associated with text mode vmem within first_page_table. Each terminal owns
+ * TERM_VMEM_PAGES pages of it, starting at SCREEN_VMEM_PT, and the VGA start address picks
+ * which terminal is on screen */
 #define SCREEN_VMEM_PT      VIDEO / PAGE_SIZE       /* 184 */
-#define TERM_VMEM_PT        186
+#define TERM_VMEM_PAGES     2
+#define TERM_VMEM_SIZE      (TERM_VMEM_PAGES * PAGE_SIZE)
 
 /* Defines where in memory kernel block starts and ends */
 #define KERNEL_START        KERNEL_PD * BIG_PAGE_SIZE
@@ -50,6 +53,10 @@
 /* Address in memory for vidmap page */
 #define VIDMAP_ADDR         ( VIDMAP_PD * BIG_PAGE_SIZE )  
 
+/* Read-only vdso page sits right after the vidmap page */
+#define VDSO_PT             1
+#define VDSO_ADDR           ( VIDMAP_ADDR + (VDSO_PT * PAGE_SIZE) )
+
 /* Defines where in virtual memory user program starts and ends */
 #define USR_PAGE            0x08000000
 #define USR_PRGM_START      0x08048000
@@ -145,12 +152,12 @@ extern void paging_init();
 /* Load user program at specified process (PID) offset */
 extern void page_user_program(uint32_t pid);
 
+/* Map a 4MB uncached page for memory mapped registers (identity mapped) */
+extern void page_mmio(uint32_t pd);
+
 /* Load vidmap to specified address from PID */
 extern void page_vidmap(uint32_t pid);
 
-/* Copy current terminal vmem to screen vmem or vice versa */
-extern void copy_term_vmem(uint32_t terminal, uint32_t screen);
-
 /* Get pointer to terminal vmem */
 extern void* get_term_vmem(uint32_t terminal);
 
@@ -119,6 +119,7 @@ void init_pcb(uint32_t pid) {
         /* Clear the pcb before initializing the fda (useful for when we halt a process) */
         clear_pcb(pid);
         pcbs[pid]->in_use = 1;
+        pcbs[pid]->saved_mode = -1;
         curr_pid = pid;
 
         /* Adriel -> I think we can just call terminal_open in here without a sys call */
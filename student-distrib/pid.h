@@ -11,6 +11,8 @@
 #include "syscall.h"
 #include "filesystem.h"
 #include "kboard.h"
+#include "timer.h"
+#include "strace.h"
 
 /* Defines for PIDs */
 #define PID_SIZE            8192            /* Size of a PID is 8kb in memory */
@@ -86,11 +88,25 @@ typedef struct __attribute__((packed)) pcb {
     int32_t pid;                                    /* Used for showing PID number that pcb is stored in */
     int32_t parent_pid;                             /* Used for showing parent process, -1 if process is root */
     int32_t terminal;                               /* Used for showing which terminal current PCB/PID belongs to */
+    int32_t saved_mode;                             /* Terminal input mode from before the process first changed it, -1 if it never did */
     volatile int exception;                         /* Shows if an exception was thrown during process execution and used for squashing (1 or 0) */
+    int32_t nice;                                   /* Scheduling niceness, lower nice gets a bigger share of the CPU (NICE_MIN to NICE_MAX) */
+    volatile int32_t sleeping;                      /* Shows if process is waiting on its sleep timer, the scheduler skips it (1 or 0) */
+    uint64_t utime;                                 /* TSC cycles spent running user code */
+    uint64_t stime;                                 /* TSC cycles spent in the kernel for this process */
+    uint64_t cutime;                                /* utime of halted children (and their children) */
+    uint64_t cstime;                                /* stime of halted children (and their children) */
+    uint32_t sys_num;                               /* Syscall the process is in (SYSSTAT_NONE if none, see sysstat.c) */
+    uint64_t sys_start;                             /* TSC value sys_num was entered at */
+    uint32_t strace;                                /* STRACE_SELF and/or STRACE_CHILDREN, 0 if not traced */
+    uint32_t sys_args[3];                           /* Args of sys_num, only kept while traced */
+    char sys_str[STRACE_STR_LEN];                   /* String arg of sys_num, only kept while traced */
     saved_regs_t curr_regs;                         /* PCBs current registers */
     fd_file_t fd_array[FD_ARRAY_SIZE];              /* fd_array (fda) storing file descriptors for current PID */
     int32_t curr_executable_fd;                     /* Stores index (fd) of the current executable that is running, -1 of process is root */
     char args[BUF_SIZE];                            /* Pointer to process args */
+    char name[MAX_FILE_NAME_LENGTH + 1];            /* Name of the executable the process is running */
+    uint32_t image_size;                            /* Bytes of program image loaded by execute */
 } pcb_t;
 
 /* Initializing file operation tables */
@@ -111,6 +127,10 @@ pcb_t *pcbs[PID_NUM];
 uint32_t fda_spaces[PID_NUM][FD_ARRAY_SIZE];
 uint32_t fda_full[PID_NUM];
 
+/* Timer used by the sleep syscall to wake each process back up, kept out of the packed pcb_t
+ * so the timer wheel's links stay aligned */
+ktimer_t sleep_timers[PID_NUM];
+
 /* Initializes all PIDs at their respective locations in memory */
 extern int32_t init_pids();
 
@@ -11,10 +11,30 @@ void enable_pit_interrupt(){
 void pit_init(){
     cli();
 
-    int divisor = PIT_DIVISOR(20); /* Calculate our divisor */
+    int divisor = PIT_DIVISOR(PIT_TICK_MS); /* Calculate our divisor */
     outb(0x36, PIT_COMMAND_REGISTER); /* Set our command byte 0x36 */
     outb(divisor & 0xFF, PIT_CHANNEL_0); /* Set low byte of divisor */
     outb(divisor >> 8, PIT_CHANNEL_0); /* Set high byte of divisor */
 
     sti();
 }
+
+/* Start a channel 2 countdown
+ * Channel 2 is only wired to the speaker, so it can be used for calibration
+ * without touching the scheduler tick on channel 0 */
+void pit_ch2_start(uint32_t ms){
+    int latch = PIT_DIVISOR(ms);
+
+    /* Raise the channel 2 gate with the speaker off */
+    outb((inb(PIT_CH2_GATE_PORT) & ~PIT_CH2_SPEAKER) | PIT_CH2_GATE, PIT_CH2_GATE_PORT);
+
+    /* Channel 2, lobyte/hibyte, mode 0 (OUT goes high once the count hits 0) */
+    outb(0xB0, PIT_COMMAND_REGISTER);
+    outb(latch & 0xFF, PIT_CHANNEL_2);
+    outb(latch >> 8, PIT_CHANNEL_2);
+}
+
+/* Wait for the channel 2 countdown to finish */
+void pit_ch2_wait(){
+    while ((inb(PIT_CH2_GATE_PORT) & PIT_CH2_OUT) == 0);
+}
@@ -15,11 +15,20 @@
 #define PIT_CHANNEL_2           0x42   
 #define PIT_COMMAND_REGISTER    0x43
 
+/* Channel 2 gate/output bits live in the keyboard controller's port B */
+#define PIT_CH2_GATE_PORT       0x61
+#define PIT_CH2_GATE            0x01
+#define PIT_CH2_SPEAKER         0x02
+#define PIT_CH2_OUT             0x20
+
 /* PIT rate/frequency data */
 #define PIT_RATE_CONSTANT       1193182
 
-/* PIT divisor, ms = millisecond */
-#define PIT_DIVISOR(ms)         ( (ms/1000) * PIT_RATE_CONSTANT )
+/* PIT divisor, ms = millisecond (multiply first, ms/1000 is always 0 in integer math) */
+#define PIT_DIVISOR(ms)         ( (PIT_RATE_CONSTANT * (ms)) / 1000 )
+
+/* Length of one PIT tick (scheduler quantum and timer wheel resolution) */
+#define PIT_TICK_MS             10
 
 /* maths:
  * 1/f = T
@@ -38,6 +47,12 @@ extern void pit_init();
 /* Enable IRQ line connected to PIT */
 extern void enable_pit_interrupt();
 
+/* Starts a one-shot countdown of ms milliseconds on channel 2 (used to calibrate other clocks) */
+extern void pit_ch2_start(uint32_t ms);
+
+/* Spins until the channel 2 countdown reaches 0 */
+extern void pit_ch2_wait();
+
 #endif /* _PIT_H */
 
 #endif /* ASM */
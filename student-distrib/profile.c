@@ -0,0 +1,161 @@
+/* profile.c - Sampling profiler driven by the timer and RTC interrupts
+ * vim:ts=4 noexpandtab
+ *
+ * Only the BSP takes timer and RTC interrupts and processes only run on the BSP, so
+ * the buffer is only ever touched with interrupts off on one CPU and needs no lock.
+ */
+
+#include "profile.h"
+#include "lib.h"
+#include "serial.h"
+
+/* Program names seen during a run, a sample belongs to the last exec of its pid before it */
+typedef struct profile_exec {
+    uint32_t sample;                        /* Index of the first sample taken after the exec */
+    uint32_t pid;
+    char name[MAX_FILE_NAME_LENGTH + 1];
+} profile_exec_t;
+
+static profile_sample_t samples[PROFILE_SIZE];
+static uint32_t nsamples;
+static profile_exec_t execs[PROFILE_EXECS];
+static uint32_t nexecs;
+static volatile int32_t profiling;
+
+/* Local functions */
+static void profile_dump();
+static void dump_exec(const profile_exec_t* exec);
+
+/* profile_sample
+ * 
+ * Inputs: frame - what the CPU pushed when the interrupt came in
+ *         source - PROFILE_* interrupt that took the sample
+ * Outputs: None
+ */
+void profile_sample(const iret_frame_t* frame, uint32_t source) {
+    profile_sample_t* s;
+
+    if (!profiling || nsamples == PROFILE_SIZE) return;
+
+    s = &samples[nsamples++];
+    s->eip = frame->eip;
+    s->cpl = frame->cs & 0x3;
+    s->pid = curr_pid;
+    s->source = source;
+}
+
+/* profile_exec
+ * 
+ * Inputs: pid - process that just started
+ *         name - program it runs
+ * Outputs: None
+ */
+void profile_exec(uint32_t pid, const char* name) {
+    if (!profiling || nexecs == PROFILE_EXECS) return;
+
+    execs[nexecs].sample = nsamples;
+    execs[nexecs].pid = pid;
+    strncpy((int8_t*)execs[nexecs].name, (const int8_t*)name, MAX_FILE_NAME_LENGTH);
+    execs[nexecs].name[MAX_FILE_NAME_LENGTH] = '\0';
+    nexecs++;
+}
+
+/* profile_ctl
+ * 
+ * Inputs: cmd - PROFILE_START, PROFILE_STOP or PROFILE_DUMP
+ * Outputs: number of samples in the buffer, -1 if cmd is invalid
+ */
+int32_t profile_ctl(int32_t cmd) {
+    uint32_t flags;
+    int pid;
+
+    cli_and_save(flags);
+    switch (cmd) {
+        case PROFILE_START:
+            nsamples = 0;
+            nexecs = 0;
+            profiling = 1;
+            /* Processes that are already running keep their names */
+            for (pid = 0; pid < PID_NUM; pid++)
+                if (pcbs[pid]->in_use) profile_exec(pid, pcbs[pid]->name);
+            break;
+        case PROFILE_STOP:
+            profiling = 0;
+            break;
+        case PROFILE_DUMP:
+            /* Nothing writes the buffer once sampling is off, so the (slow) dump can run with interrupts on */
+            profiling = 0;
+            restore_flags(flags);
+            profile_dump();
+            return nsamples;
+        default:
+            restore_flags(flags);
+            return -1;
+    }
+    restore_flags(flags);
+    return nsamples;
+}
+
+/* profile_read
+ * 
+ * Inputs: out - array to fill
+ *         count - number of entries out has room for
+ * Outputs: number of samples copied
+ */
+int32_t profile_read(profile_sample_t* out, int32_t count) {
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if (count > nsamples) count = nsamples;
+    memcpy(out, samples, count * sizeof(profile_sample_t));
+    restore_flags(flags);
+
+    return count;
+}
+
+/* profile_dump
+ * 
+ * Writes the run to COM1 in the line format symbolize.py reads:
+ *   profile begin <samples>
+ *   exec <sample index> <pid> <name>
+ *   sample <pid> <cpl> <eip in hex> <source>
+ *   profile end
+ * Inputs: None
+ * Outputs: None
+ */
+static void profile_dump() {
+    uint32_t i, e = 0;
+
+    serial_puts("profile begin ");
+    serial_putnum(nsamples, 10);
+    serial_putc('\n');
+
+    for (i = 0; i < nsamples; i++) {
+        /* Interleave the execs so the log reads in order */
+        for (; e < nexecs && execs[e].sample <= i; e++) dump_exec(&execs[e]);
+
+        serial_puts("sample ");
+        serial_putnum(samples[i].pid, 10);
+        serial_putc(' ');
+        serial_putnum(samples[i].cpl, 10);
+        serial_putc(' ');
+        serial_putnum(samples[i].eip, 16);
+        serial_putc(' ');
+        serial_putnum(samples[i].source, 10);
+        serial_putc('\n');
+    }
+    for (; e < nexecs; e++) dump_exec(&execs[e]);
+
+    serial_puts("profile end\n");
+}
+
+/* Writes one exec line */
+static void dump_exec(const profile_exec_t* exec) {
+    serial_puts("exec ");
+    serial_putnum(exec->sample, 10);
+    serial_putc(' ');
+    serial_putnum(exec->pid, 10);
+    serial_putc(' ');
+    serial_puts((const int8_t*)exec->name);
+    serial_putc('\n');
+}
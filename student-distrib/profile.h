@@ -0,0 +1,58 @@
+/* profile.h - Sampling profiler driven by the timer and RTC interrupts
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include "types.h"
+#include "pid.h"
+
+/* Samples kept per profiling run, sampling stops once the buffer is full */
+#define PROFILE_SIZE        16384
+
+/* Programs started during a run that we remember the names of */
+#define PROFILE_EXECS       64
+
+/* Interrupt a sample was taken on (passed in by sampled_interrupt_link) */
+#define PROFILE_PIT         0
+#define PROFILE_LAPIC       1
+#define PROFILE_RTC         2
+
+/* Commands for the profile syscall */
+#define PROFILE_START       0               /* Throws away old samples and starts sampling */
+#define PROFILE_STOP        1               /* Stops sampling */
+#define PROFILE_DUMP        2               /* Writes every sample to COM1 as text */
+
+#ifndef ASM
+
+/* What the CPU was doing when the interrupt came in, returned as is by KSTAT_PROFILE */
+typedef struct profile_sample {
+    uint32_t eip;
+    uint16_t pid;
+    uint8_t cpl;                            /* 0 = kernel, 3 = user */
+    uint8_t source;                         /* PROFILE_PIT, PROFILE_LAPIC or PROFILE_RTC */
+} profile_sample_t;
+
+/* Top of the stack an interrupt leaves behind (esp and ss only when coming from user space) */
+typedef struct iret_frame {
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+} iret_frame_t;
+
+/* Records a sample, called by the interrupt link before the handler */
+extern void profile_sample(const iret_frame_t* frame, uint32_t source);
+
+/* Remembers the name a pid started running so samples can be matched with the right binary */
+extern void profile_exec(uint32_t pid, const char* name);
+
+/* Handles the PROFILE_* commands, returns the number of samples taken */
+extern int32_t profile_ctl(int32_t cmd);
+
+/* Copies up to count samples of the current run, oldest first, returns how many */
+extern int32_t profile_read(profile_sample_t* samples, int32_t count);
+
+#endif /* _PROFILE_H */
+
+#endif /* ASM */
@@ -3,6 +3,7 @@
  */
 
 #include "rtc.h"
+#include "latency.h"
 
 /* Local functions */
 static uint32_t calculate_rtc_rate(uint32_t freq);
@@ -141,9 +142,11 @@ int32_t rtc_close(int32_t fd){
  * Function: blocks a single RTC interrupt and returns */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
     /* Wait for RTC handler to clear flag */
+    latency_wait(terminal_active, LAT_RTC);
     while(!terminal_rtc_data[terminal_active].rtc_read_flag){
         continue;
     }
+    latency_run(terminal_active, LAT_RTC);
 
     /* Clear interrupts for critical section (terminal_active) */
     cli();
@@ -3,6 +3,10 @@
  */
 
 #include "scheduler.h"
+#include "trace.h"
+#include "irqstat.h"
+#include "vdso.h"
+#include "acct.h"
 
 /* Start kernel with terminal 0 shown and active (terminal_active will increment in schedule()) */
 volatile int32_t terminal_shown = 0;
@@ -12,14 +16,47 @@ volatile int32_t terminal_active = TERMINAL_COUNT - 1;
 volatile int32_t base_processes[TERMINAL_COUNT] = {-1, -1, -1};
 volatile int32_t active_processes[TERMINAL_COUNT] = {-1, -1, -1};
 
+/* No terminal is boosted at boot */
+volatile int32_t terminal_boost = -1;
+
+/* Local functions */
+static int32_t pick_next_terminal();
+static int32_t terminal_runnable(int32_t terminal);
+
+/* Stride scheduling pass value for each terminal, the terminal with the lowest pass runs next */
+static uint32_t terminal_pass[TERMINAL_COUNT] = {0, 0, 0};
+
+/* Weight of a process for each nice value (NICE_MIN to NICE_MAX), each step is ~1.25x.
+ * Same table as the Linux CFS scheduler so nice values behave the way people expect */
+static const uint32_t nice_to_weight[NICE_MAX - NICE_MIN + 1] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */ 9548, 7620, 6100, 4904, 3906,
+    /*  -5 */ 3121, 2501, 1991, 1586, 1277,
+    /*   0 */ 1024, 820, 655, 526, 423,
+    /*   5 */ 335, 272, 215, 172, 137,
+    /*  10 */ 110, 87, 70, 56, 45,
+    /*  15 */ 36, 29, 23, 18, 15
+};
+
 /* The big boy 
  *
  * Schedules next active terminal and sets up the context switch, vidmap, keyboard, rtc, etc. */
 void schedule() {
     /* Set up variables for scheduler */
     uint32_t old_term = terminal_active;
-    uint32_t curr_term = (terminal_active + 1) % TERMINAL_COUNT;
+
+    /* Charge the terminal that just ran for its tick */
+    if (terminal_runnable(old_term))
+        terminal_pass[old_term] += STRIDE_SCALE / nice_to_weight[pcbs[active_processes[old_term]]->nice - NICE_MIN];
+
+    uint32_t curr_term = pick_next_terminal();
+
+    /* Keep running the same process if it's still the best choice */
+    if (curr_term == old_term && base_processes[curr_term] != -1) return;
+
     terminal_active = curr_term;
+    trace_record(TRACE_SCHED, old_term, curr_term, active_processes[curr_term]);
 
     /* Set up vidmap */
     change_vidmap(curr_term);
@@ -42,10 +79,13 @@ void schedule() {
         /* Update pid */
         uint32_t from_pid = curr_pid;
         uint32_t to_pid = active_processes[curr_term];
+        acct_charge();
+        irqstat_switch();
         curr_pid = to_pid;
         
         /* Page to next process */
         page_user_program(to_pid);
+        vdso_set_current(to_pid, curr_term);
 
         /* Set up vars for context switch */
         tss.esp0 = (uint32_t)get_pstack_loc(to_pid);
@@ -56,28 +96,115 @@ void schedule() {
     }
 }
 
+/* pick_next_terminal
+ *
+ * Inputs: None
+ * Outputs: terminal that should run next
+ *
+ * Terminals without a base shell are started first. After that a boosted terminal (its reader
+ * was waiting for the key just typed, see terminal_key_push) runs right away, otherwise the
+ * terminal with the lowest pass value runs */
+static int32_t pick_next_terminal() {
+    int i;
+    int32_t term;
+    int32_t next = -1;
+
+    /* Start terminals that have no base shell yet in order */
+    for (i = 1; i <= TERMINAL_COUNT; i++) {
+        term = (terminal_active + i) % TERMINAL_COUNT;
+        if (base_processes[term] == -1) {
+            /* Don't let a new terminal start with a huge head start over the others */
+            terminal_pass[term] = terminal_pass[terminal_active];
+            return term;
+        }
+    }
+
+    /* Interactive latency boost for the shown terminal */
+    if (terminal_boost != -1) {
+        next = terminal_boost;
+        terminal_boost = -1;
+        if (terminal_runnable(next)) return next;
+        next = -1;
+    }
+
+    /* Lowest pass wins, ties go to the next terminal in round robin order (signed compare handles wrap around) */
+    for (i = 1; i <= TERMINAL_COUNT; i++) {
+        term = (terminal_active + i) % TERMINAL_COUNT;
+        if (!terminal_runnable(term)) continue;
+        if (next == -1 || (int32_t)(terminal_pass[term] - terminal_pass[next]) < 0) next = term;
+    }
+
+    /* Everyone is asleep, stay on the current terminal (it will hlt until a timer fires) */
+    if (next == -1) next = terminal_active;
+
+    return next;
+}
+
+/* terminal_runnable
+ *
+ * Inputs: terminal - terminal to check
+ * Outputs: 1 if the terminal's active process can run, 0 if it is sleeping or has no process */
+static int32_t terminal_runnable(int32_t terminal) {
+    if (active_processes[terminal] == -1) return 0;
+    return !pcbs[active_processes[terminal]]->sleeping;
+}
+
+/* scheduler_wake
+ *
+ * Inputs: terminal - terminal whose active process just woke up
+ *
+ * Moves the terminal's pass up to the lowest pass of the terminals that kept running, otherwise a
+ * process that slept for a long time would hog the CPU until its pass caught up with everyone else */
+void scheduler_wake(int32_t terminal) {
+    int i;
+    int32_t min = -1;
+
+    for (i = 0; i < TERMINAL_COUNT; i++) {
+        if (i == terminal || !terminal_runnable(i)) continue;
+        if (min == -1 || (int32_t)(terminal_pass[i] - terminal_pass[min]) < 0) min = i;
+    }
+
+    if (min != -1 && (int32_t)(terminal_pass[terminal] - terminal_pass[min]) < 0)
+        terminal_pass[terminal] = terminal_pass[min];
+}
+
+/* scheduler_boost
+ *
+ * Inputs: terminal - terminal whose blocked reader just got the key it was waiting for
+ *
+ * Makes the terminal run on the next schedule() so interactive shells stay responsive
+ * even when CPU bound programs are running in the other terminals */
+void scheduler_boost(int32_t terminal) {
+    if (terminal < 0 || terminal >= TERMINAL_COUNT || base_processes[terminal] == -1) return;
+    terminal_boost = terminal;
+}
+
+/* clamp_nice
+ *
+ * Inputs: nice - niceness value to clamp
+ * Outputs: nice clamped to [NICE_MIN, NICE_MAX] */
+int32_t clamp_nice(int32_t nice) {
+    if (nice < NICE_MIN) return NICE_MIN;
+    if (nice > NICE_MAX) return NICE_MAX;
+    return nice;
+}
+
 /* terminal_switch 
  *
  * Inputs: curr_term - new terminal that is to be displayed on screen
  * 
  * Displays new terminal on screen specified by user on keyboard input */
 void terminal_switch(uint32_t curr_term) {
-    uint32_t old_term = terminal_shown;
-    terminal_shown = curr_term;
+    uint32_t flags;
+    uint32_t old_term;
 
-    /* Only change vmem and screens if terminals are different */
-    if (old_term != curr_term) {
-        /* Copy screen vmem to old term vmem */
-        copy_term_vmem(old_term, 0);
-        /* Copy curr term vmem to screen vmem */
-        copy_term_vmem(curr_term, 1);
-
-        /* Switch to new screen and update cursor */
-        switch_screen(old_term, curr_term, 1);
-
-        /* ^^^ The screen will switch back to the active process at the end of the keyboard handler */
+    cli_and_save(flags);
+    old_term = terminal_shown;
+    terminal_shown = curr_term;
 
-        /* Update vidmap for active terminal */
-        change_vidmap(terminal_active);
-    }
+    /* Only change screens if terminals are different. Every terminal keeps its own vmem,
+     * just point the screen (and the cursor) at the new one, putc/putbuf keep writing
+     * to the active terminal's console */
+    if (old_term != curr_term) console_show(curr_term);
+    restore_flags(flags);
 }
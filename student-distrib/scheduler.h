@@ -10,6 +10,17 @@
 
 #define TERMINAL_COUNT  3
 
+/* Niceness range for process priorities (same range as Unix nice) */
+#define NICE_MIN        -20
+#define NICE_MAX        19
+#define NICE_DEFAULT    0
+
+/* Niceness is returned to user space as NICE_BIAS - nice so it is always positive */
+#define NICE_BIAS       20
+
+/* Pass values grow by STRIDE_SCALE / weight every tick a terminal runs */
+#define STRIDE_SCALE    (1 << 20)
+
 #ifndef ASM
 
 /* Shows which terminal is currently active in scheduler (TA) */
@@ -24,9 +35,21 @@ extern volatile int32_t base_processes[TERMINAL_COUNT];
 /* Showcases which processes are active in each terminal (-1 if terminal has no active process) */
 extern volatile int32_t active_processes[TERMINAL_COUNT];
 
+/* Terminal that gets picked on the next schedule() regardless of its pass (-1 if none) */
+extern volatile int32_t terminal_boost;
+
 /* The big boy */
 extern void schedule();
 
+/* Gives the shown terminal a latency boost on the next schedule() */
+extern void scheduler_boost(int32_t terminal);
+
+/* Makes a terminal runnable again after its process wakes up from sleep */
+extern void scheduler_wake(int32_t terminal);
+
+/* Clamps a niceness value into the range [NICE_MIN, NICE_MAX] */
+extern int32_t clamp_nice(int32_t nice);
+
 /* Displays new terminal on screen specified by user on keyboard input */
 extern void terminal_switch(uint32_t curr_term);
 
@@ -0,0 +1,100 @@
+/* scrollback.c - Lines that scrolled off a terminal's screen
+ * vim:ts=4 noexpandtab
+ *
+ * Each line is stored as its length (up to the last cell that isn't blank), the
+ * characters, and then the attributes run length encoded:
+ *
+ *     n, char[n], r, (run length, attr)[r]
+ *
+ * Almost every line is one color so that's 2 bytes for attributes instead of 80.
+ * Lines are pushed by scroll_up in lib.c with interrupts off, readers (the keyboard
+ * handler drawing the view) run with interrupts off too.
+ */
+
+#include "scrollback.h"
+
+#define SB_BYTE(sb, off)    ((sb)->data[(off) & SCROLLBACK_BYTES_MASK])
+
+/* scrollback_push
+ *
+ * Inputs: sb - scrollback to add to
+ *         row - cells of the line
+ *         cols - number of cells in row
+ *         blank - cell value that doesn't need storing at the end of the line
+ * Outputs: None
+ */
+void scrollback_push(scrollback_t* sb, const uint16_t* row, int32_t cols, uint16_t blank) {
+    uint32_t off, size;
+    int32_t n, runs, i;
+
+    /* Work out the size first so old lines can be dropped to make room */
+    for (n = cols; n > 0 && row[n - 1] == blank; n--);
+    runs = n ? 1 : 0;
+    for (i = 1; i < n; i++)
+        if ((row[i] >> 8) != (row[i - 1] >> 8)) runs++;
+    size = 2 + n + 2 * runs;
+
+    while (sb->head - sb->tail == SCROLLBACK_LINES ||
+           (sb->head != sb->tail && sb->data_head + size - sb->start[sb->tail & SCROLLBACK_LINES_MASK] > SCROLLBACK_BYTES))
+        sb->tail++;
+
+    off = sb->data_head;
+    sb->start[sb->head & SCROLLBACK_LINES_MASK] = off;
+
+    SB_BYTE(sb, off++) = n;
+    for (i = 0; i < n; i++)
+        SB_BYTE(sb, off++) = row[i] & 0xFF;
+
+    SB_BYTE(sb, off++) = runs;
+    for (i = 0; i < n; i++) {
+        if (i == 0 || (row[i] >> 8) != (row[i - 1] >> 8)) {
+            SB_BYTE(sb, off++) = 1;
+            SB_BYTE(sb, off++) = row[i] >> 8;
+        } else {
+            SB_BYTE(sb, off - 2)++;
+        }
+    }
+
+    sb->data_head = off;
+    sb->head++;
+}
+
+/* scrollback_count
+ *
+ * Inputs: sb - scrollback to look at
+ * Outputs: number of lines kept
+ */
+int32_t scrollback_count(const scrollback_t* sb) {
+    return sb->head - sb->tail;
+}
+
+/* scrollback_get
+ *
+ * Inputs: sb - scrollback to read from
+ *         back - which line, 1 is the newest and scrollback_count(sb) the oldest
+ *         row - cells to fill
+ *         cols - number of cells in row
+ *         blank - cell value to fill the rest of the row with
+ * Outputs: None
+ */
+void scrollback_get(const scrollback_t* sb, int32_t back, uint16_t* row, int32_t cols, uint16_t blank) {
+    uint32_t off, attr_off;
+    int32_t n, runs, len, i, j;
+
+    off = sb->start[(sb->head - back) & SCROLLBACK_LINES_MASK];
+    n = SB_BYTE(sb, off);
+    if (n > cols) n = cols;
+
+    /* Attributes first, they come after the characters */
+    attr_off = off + 1 + SB_BYTE(sb, off);
+    runs = SB_BYTE(sb, attr_off++);
+    for (i = 0, j = 0; i < runs; i++, attr_off += 2)
+        for (len = SB_BYTE(sb, attr_off); len > 0 && j < n; len--, j++)
+            row[j] = SB_BYTE(sb, attr_off + 1) << 8;
+
+    for (i = 0, off++; i < n; i++, off++)
+        row[i] |= SB_BYTE(sb, off);
+
+    for (; i < cols; i++)
+        row[i] = blank;
+}
@@ -0,0 +1,43 @@
+/* scrollback.h - Lines that scrolled off a terminal's screen
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _SCROLLBACK_H
+#define _SCROLLBACK_H
+
+#include "types.h"
+
+/* Lines kept per terminal and bytes to keep them in (both powers of 2), whichever runs out first
+ * drops the oldest lines. A line takes 2 bytes plus its text up to the last non blank cell plus
+ * 2 bytes per run of cells with the same attribute, so about 45 bytes for a typical shell line */
+#define SCROLLBACK_LINES    256
+#define SCROLLBACK_BYTES    16384
+
+#define SCROLLBACK_LINES_MASK   (SCROLLBACK_LINES - 1)
+#define SCROLLBACK_BYTES_MASK   (SCROLLBACK_BYTES - 1)
+
+/* Lines Shift+PageUp/PageDown move the view by */
+#define SCROLLBACK_STEP     12
+
+#ifndef ASM
+
+typedef struct scrollback {
+    uint8_t data[SCROLLBACK_BYTES];         /* Encoded lines, a ring */
+    uint32_t start[SCROLLBACK_LINES];       /* Unwrapped offset into data each line starts at, a ring */
+    uint32_t head;                          /* Lines ever pushed, the newest line is head - 1 */
+    uint32_t tail;                          /* Oldest line still kept */
+    uint32_t data_head;                     /* Unwrapped offset the next line gets written at */
+} scrollback_t;
+
+/* Adds a row of cols cells, cells equal to blank at the end of the row aren't stored */
+extern void scrollback_push(scrollback_t* sb, const uint16_t* row, int32_t cols, uint16_t blank);
+
+/* Number of lines kept */
+extern int32_t scrollback_count(const scrollback_t* sb);
+
+/* Decodes the line back lines up from the newest (1 is the newest) into row */
+extern void scrollback_get(const scrollback_t* sb, int32_t back, uint16_t* row, int32_t cols, uint16_t blank);
+
+#endif /* _SCROLLBACK_H */
+
+#endif /* ASM */
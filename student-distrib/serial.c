@@ -0,0 +1,52 @@
+/* serial.c - Polled output on the first serial port (COM1)
+ * vim:ts=4 noexpandtab
+ */
+
+#include "serial.h"
+#include "lib.h"
+
+/* serial_init
+ * 
+ * Inputs: None
+ * Outputs: None
+ */
+void serial_init() {
+    outb(0x00, COM1_PORT + SERIAL_IER);
+    outb(SERIAL_LCR_DLAB, COM1_PORT + SERIAL_LCR);
+    outb(SERIAL_DIVISOR & 0xFF, COM1_PORT + SERIAL_DATA);
+    outb(SERIAL_DIVISOR >> 8, COM1_PORT + SERIAL_IER);
+    outb(SERIAL_LCR_8N1, COM1_PORT + SERIAL_LCR);
+    outb(SERIAL_FCR_ENABLE, COM1_PORT + SERIAL_FCR);
+    outb(SERIAL_MCR_DTR_RTS, COM1_PORT + SERIAL_MCR);
+}
+
+/* serial_putc
+ * 
+ * Inputs: c - character to send
+ * Outputs: None
+ */
+void serial_putc(uint8_t c) {
+    if (c == '\n') serial_putc('\r');
+    while (!(inb(COM1_PORT + SERIAL_LSR) & SERIAL_LSR_THRE));
+    outb(c, COM1_PORT + SERIAL_DATA);
+}
+
+/* serial_puts
+ * 
+ * Inputs: s - string to send
+ * Outputs: None
+ */
+void serial_puts(const int8_t* s) {
+    while (*s) serial_putc(*s++);
+}
+
+/* serial_putnum
+ * 
+ * Inputs: value - number to send
+ *         radix - base to send it in (2 to 36)
+ * Outputs: None
+ */
+void serial_putnum(uint32_t value, int32_t radix) {
+    int8_t buf[33];
+    serial_puts(itoa(value, buf, radix));
+}
@@ -0,0 +1,44 @@
+/* serial.h - Polled output on the first serial port (COM1)
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include "types.h"
+
+/* COM1 registers (offsets from the base port) */
+#define COM1_PORT           0x3F8
+#define SERIAL_DATA         0               /* Data, or divisor low byte when DLAB is set */
+#define SERIAL_IER          1               /* Interrupt enable, or divisor high byte when DLAB is set */
+#define SERIAL_FCR          2               /* FIFO control */
+#define SERIAL_LCR          3               /* Line control */
+#define SERIAL_MCR          4               /* Modem control */
+#define SERIAL_LSR          5               /* Line status */
+
+#define SERIAL_LCR_8N1      0x03
+#define SERIAL_LCR_DLAB     0x80
+#define SERIAL_FCR_ENABLE   0xC7            /* Enable and clear FIFOs, 14 byte threshold */
+#define SERIAL_MCR_DTR_RTS  0x03
+#define SERIAL_LSR_THRE     0x20            /* Transmit holding register empty */
+
+/* 115200 / divisor baud */
+#define SERIAL_DIVISOR      1
+
+#ifndef ASM
+
+/* Sets COM1 up for 115200 8N1 with interrupts off */
+extern void serial_init();
+
+/* Writes one character, waiting for the transmitter (\n is sent as \r\n) */
+extern void serial_putc(uint8_t c);
+
+/* Writes a NUL terminated string */
+extern void serial_puts(const int8_t* s);
+
+/* Writes value in the given radix */
+extern void serial_putnum(uint32_t value, int32_t radix);
+
+#endif /* _SERIAL_H */
+
+#endif /* ASM */
@@ -0,0 +1,133 @@
+/* smp.c - Application processor bring-up and per-CPU data
+ * vim:ts=4 noexpandtab
+ */
+
+#include "smp.h"
+#include "apic.h"
+#include "clock.h"
+#include "paging.h"
+#include "lib.h"
+#include "irqstat.h"
+
+/* Local functions */
+static void set_tss_desc(seg_desc_t* desc, tss_t* t);
+
+/* Defined in smp_trampoline.S */
+extern uint8_t smp_trampoline_start[];
+extern uint8_t smp_trampoline_end[];
+extern uint8_t smp_trampoline_gdt[];
+extern volatile uint32_t ap_next_id;
+
+cpu_t cpus[MAX_CPUS];
+volatile uint32_t cpu_count = 1;
+
+/* TSS and boot stack for each AP (the BSP keeps using tss from x86_desc.S) */
+static tss_t ap_tss[NUM_AP_TSS] __attribute__((aligned(16)));
+uint8_t ap_stacks[NUM_AP_TSS][AP_STACK_SIZE] __attribute__((aligned(16)));
+
+/* smp_init
+ * 
+ * Fills in the BSP's cpu_t and wakes up every other CPU with a broadcast INIT-SIPI-SIPI.
+ * APs number themselves as they arrive (see smp_trampoline.S), so we don't need to parse
+ * the MP or ACPI tables to find them.
+ * Needs paging, apic_init() and clock_init() (for the delays), interrupts off.
+ * Inputs: None
+ * Outputs: None
+ */
+void smp_init() {
+    uint32_t size = (uint32_t)smp_trampoline_end - (uint32_t)smp_trampoline_start;
+    uint8_t* gdt = (uint8_t*)(TRAMPOLINE_ADDR + ((uint32_t)smp_trampoline_gdt - (uint32_t)smp_trampoline_start));
+
+    cpus[0].id = 0;
+    cpus[0].apic_id = apic_present ? lapic_id() : 0;
+    cpus[0].online = 1;
+    cpus[0].tss = &tss;
+    cpus[0].tss_sel = KERNEL_TSS;
+    cpus[0].irq_vector = IRQSTAT_NONE;
+
+    if (!apic_present) return;
+
+    /* Copy the real mode code below 1MB, the descriptor is 6 bytes (size then address)
+     * so write it through the fields after x86_desc_t's padding */
+    first_page_table[TRAMPOLINE_PT].present = 1;
+    flush_tlb();
+    memcpy((void*)TRAMPOLINE_ADDR, smp_trampoline_start, size);
+    memcpy(gdt, &gdt_desc.size, sizeof(gdt_desc.size) + sizeof(gdt_desc.addr));
+
+    /* INIT, then two STARTUPs as the MP spec asks for */
+    lapic_send_ipi(0, ICR_ALL_BUT_SELF | ICR_LEVEL_ASSERT | ICR_INIT);
+    clock_udelay(INIT_DELAY_US);
+    lapic_send_ipi(0, ICR_ALL_BUT_SELF | ICR_STARTUP | TRAMPOLINE_VECTOR);
+    clock_udelay(SIPI_DELAY_US);
+    lapic_send_ipi(0, ICR_ALL_BUT_SELF | ICR_STARTUP | TRAMPOLINE_VECTOR);
+
+    /* Give the APs time to wake up, then wait for every one that took an index to finish ap_main */
+    clock_udelay(AP_WAIT_US);
+    while (cpu_count < ap_next_id && cpu_count < MAX_CPUS);
+
+    /* Every AP is past the trampoline, unmap it again so stray low addresses keep faulting */
+    first_page_table[TRAMPOLINE_PT].present = 0;
+    flush_tlb();
+
+    printf("SMP: %d CPU(s) online\n", cpu_count);
+}
+
+/* ap_main
+ * 
+ * Finishes starting an AP: turns on paging with the shared page directory, loads the IDT
+ * and this CPU's own TSS, and enables its local APIC. APs never call schedule() (see smp.h),
+ * they halt until something sends them an IPI.
+ * Inputs: id - index of this CPU in cpus[]
+ * Outputs: None (never returns)
+ */
+void ap_main(uint32_t id) {
+    cpu_t* cpu = &cpus[id];
+
+    load_page_directory(page_directory);
+    enable_paging();
+    lidt(idt_desc_ptr);
+
+    cpu->id = id;
+    cpu->tss = &ap_tss[id - 1];
+    cpu->tss_sel = AP_TSS_BASE + ((id - 1) << 3);
+    cpu->tss->ldt_segment_selector = KERNEL_LDT;
+    cpu->tss->ss0 = KERNEL_DS;
+    cpu->tss->esp0 = (uint32_t)ap_stacks[id - 1] + AP_STACK_SIZE;
+    set_tss_desc(&ap_tss_desc_ptr[id - 1], cpu->tss);
+    ltr(cpu->tss_sel);
+    lldt(KERNEL_LDT);
+
+    lapic_enable(0);
+    cpu->apic_id = lapic_id();
+    cpu->irq_vector = IRQSTAT_NONE;
+    cpu->online = 1;
+
+    asm volatile ("lock incl %0" : "+m"(cpu_count) : : "memory");
+
+    while (1) {
+        sti();
+        asm volatile ("hlt");
+    }
+}
+
+/* set_tss_desc
+ * 
+ * Builds an available 32-bit TSS descriptor, same fields kernel.c uses for the BSP's TSS
+ * Inputs: desc - GDT entry to fill in
+ *         t - TSS the entry points to
+ * Outputs: None
+ */
+static void set_tss_desc(seg_desc_t* desc, tss_t* t) {
+    seg_desc_t the_tss_desc;
+    the_tss_desc.granularity   = 0x0;
+    the_tss_desc.opsize        = 0x0;
+    the_tss_desc.reserved      = 0x0;
+    the_tss_desc.avail         = 0x0;
+    the_tss_desc.present       = 0x1;
+    the_tss_desc.dpl           = 0x0;
+    the_tss_desc.sys           = 0x0;
+    the_tss_desc.type          = 0x9;
+
+    SET_TSS_PARAMS(the_tss_desc, t, TSS_SIZE - 1);
+    *desc = the_tss_desc;
+}
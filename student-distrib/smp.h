@@ -0,0 +1,70 @@
+/* smp.h - Application processor bring-up and per-CPU data
+ * vim:ts=4 noexpandtab
+ *
+ * This only brings the APs online, it does not run anything on them. Every process runs on
+ * the BSP: processes share one page directory for user space, and curr_pid, terminal_active,
+ * terminal_shown, pcbs[] and the console state in lib.c are unlocked globals. All of that has
+ * to become per-CPU or locked before an AP can run a process.
+ */
+
+#ifndef _SMP_H
+#define _SMP_H
+
+#include "types.h"
+#include "x86_desc.h"
+
+/* One CPU per TSS slot in the GDT */
+#define MAX_CPUS            (NUM_AP_TSS + 1)
+
+/* Kernel stack for each AP while it isn't running a process */
+#define AP_STACK_SIZE       8192
+
+/* Real mode startup code gets copied here, SIPI vector = address / 4KB */
+#define TRAMPOLINE_ADDR     0x8000
+#define TRAMPOLINE_PT       8
+#define TRAMPOLINE_VECTOR   (TRAMPOLINE_ADDR >> 12)
+
+/* Delays from the Intel MP spec for INIT-SIPI-SIPI, and how long we wait for APs to check in */
+#define INIT_DELAY_US       10000
+#define SIPI_DELAY_US       200
+#define AP_WAIT_US          100000
+
+#ifndef ASM
+
+/* Everything one CPU owns */
+typedef struct cpu {
+    uint32_t id;                /* Index in cpus[] (0 is the BSP) */
+    uint32_t apic_id;           /* Local APIC id */
+    volatile int32_t online;    /* Set once the CPU is done starting up */
+    tss_t* tss;                 /* Task state segment holding this CPU's esp0 */
+    uint16_t tss_sel;           /* GDT selector of the TSS */
+    uint64_t timer_deadline;    /* TSC value the local APIC timer fires at next (TSC-deadline mode) */
+    uint64_t acct_stamp;        /* TSC value time was last charged at (see acct.c) */
+    uint32_t acct_mode;         /* ACCT_USER, ACCT_KERNEL or ACCT_IDLE */
+    int32_t irq_vector;         /* Vector whose handler is running (IRQSTAT_NONE if none, see irqstat.c) */
+    uint64_t irq_stamp;         /* TSC value irq_vector's handler was last charged at */
+} cpu_t;
+
+extern cpu_t cpus[MAX_CPUS];
+
+/* Number of CPUs that are online (including the BSP) */
+extern volatile uint32_t cpu_count;
+
+/* Starts the application processors */
+extern void smp_init();
+
+/* C entry point for an AP once it's in protected mode with a stack */
+extern void ap_main(uint32_t id);
+
+/* Index of the calling CPU, read from the task register since each CPU loads its own TSS */
+static inline uint32_t smp_cpu_id(void) {
+    uint16_t sel;
+    asm volatile ("str %0" : "=r"(sel));
+    return (sel < AP_TSS_BASE) ? 0 : ((sel - AP_TSS_BASE) >> 3) + 1;
+}
+
+#define this_cpu()  (&cpus[smp_cpu_id()])
+
+#endif /* _SMP_H */
+
+#endif /* ASM */
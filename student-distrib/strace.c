@@ -0,0 +1,123 @@
+/* strace.c - Per-process syscall tracing
+ * vim:ts=4 noexpandtab
+ *
+ * Rides on the sysstat hooks: a traced process' args are kept in its PCB when the call
+ * starts and the whole call goes into one ring when sysstat_finish ends it, so untraced
+ * processes only pay the pcb->strace test in those hooks. The ring is shared by every
+ * process; only the BSP runs processes, so cli is enough to guard it. Readers drain it
+ * through KSTAT_STRACE and can spot overwritten records by gaps in seq.
+ */
+
+#include "strace.h"
+#include "lib.h"
+#include "clock.h"
+#include "pid.h"
+
+static strace_rec_t strace_ring[STRACE_RING_SIZE];
+static uint32_t strace_head;                /* seq of the next record to write */
+static uint32_t strace_tail;                /* seq of the next record to read */
+
+/* strace_enter
+ *
+ * Inputs: pid - traced process making a syscall (pcb->sys_num is already set)
+ *         arg1, arg2, arg3 - ebx, ecx and edx
+ * Outputs: None
+ */
+void strace_enter(uint32_t pid, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    pcb_t* pcb = pcbs[pid];
+    const char* s = (const char*)arg1;
+    int i;
+
+    pcb->sys_args[0] = arg1;
+    pcb->sys_args[1] = arg2;
+    pcb->sys_args[2] = arg3;
+
+    /* Copy the string now, by the time the call ends the caller's page may be gone (execute, halt) */
+    i = 0;
+    if (pcb->sys_num == STRACE_SYS_EXECUTE || pcb->sys_num == STRACE_SYS_OPEN) {
+        for (; i < STRACE_STR_LEN - 1; i++) {
+            if ((uint32_t)(s + i) < USR_PAGE || (uint32_t)(s + i) >= USR_PAGE + BIG_PAGE_SIZE) break;
+            if (s[i] == '\0') break;
+            pcb->sys_str[i] = s[i];
+        }
+    }
+    pcb->sys_str[i] = '\0';
+}
+
+/* strace_record
+ *
+ * Inputs: pid - traced process whose syscall is done
+ *         ret - value it returns
+ *         cycles - TSC cycles the call took
+ * Outputs: None
+ */
+void strace_record(uint32_t pid, int32_t ret, uint64_t cycles) {
+    pcb_t* pcb = pcbs[pid];
+    strace_rec_t* rec;
+    uint32_t flags;
+    uint64_t us;
+
+    us = cycles_to_ns(cycles);
+    div64_32(&us, NS_PER_MS / US_PER_MS);
+
+    cli_and_save(flags);
+
+    /* Full, drop the oldest record */
+    if (strace_head - strace_tail == STRACE_RING_SIZE) strace_tail++;
+
+    rec = &strace_ring[strace_head & STRACE_RING_MASK];
+    rec->seq = strace_head++;
+    rec->pid = pid;
+    rec->num = pcb->sys_num;
+    rec->args[0] = pcb->sys_args[0];
+    rec->args[1] = pcb->sys_args[1];
+    rec->args[2] = pcb->sys_args[2];
+    rec->ret = ret;
+    rec->usec = (us >> 32) ? 0xFFFFFFFF : (uint32_t)us;
+    memcpy(rec->str, pcb->sys_str, STRACE_STR_LEN);
+
+    restore_flags(flags);
+}
+
+/* strace_set
+ *
+ * Inputs: pid - process to trace, or STRACE_CHILDREN_PID for whatever the caller executes next
+ *         on - nonzero to start tracing, 0 to stop
+ * Outputs: 0 if successful, -1 if pid isn't a process in use
+ */
+int32_t strace_set(int32_t pid, int32_t on) {
+    uint32_t bits;
+
+    if (pid == STRACE_CHILDREN_PID) {
+        bits = STRACE_CHILDREN;
+        pid = curr_pid;
+    } else {
+        if (pid < 0 || pid >= PID_NUM || !pcbs[pid]->in_use) return -1;
+        bits = STRACE_SELF | STRACE_CHILDREN;
+    }
+
+    if (on) pcbs[pid]->strace |= bits;
+    else pcbs[pid]->strace &= ~bits;
+    return 0;
+}
+
+/* strace_read
+ *
+ * Inputs: recs - array to fill
+ *         count - number of entries recs has room for
+ * Outputs: number of entries written
+ */
+int32_t strace_read(strace_rec_t* recs, int32_t count) {
+    uint32_t flags;
+    int32_t n = 0;
+
+    cli_and_save(flags);
+    while (n < count && strace_tail != strace_head) {
+        memcpy(&recs[n], &strace_ring[strace_tail & STRACE_RING_MASK], sizeof(strace_rec_t));
+        strace_tail++;
+        n++;
+    }
+    restore_flags(flags);
+
+    return n;
+}
@@ -0,0 +1,55 @@
+/* strace.h - Per-process syscall tracing
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _STRACE_H
+#define _STRACE_H
+
+#include "types.h"
+
+/* Records in the ring (power of 2), the oldest records get overwritten when it's full */
+#define STRACE_RING_SIZE    1024
+#define STRACE_RING_MASK    (STRACE_RING_SIZE - 1)
+
+/* Bytes of a string argument (execute's command, open's file name) kept with a record */
+#define STRACE_STR_LEN      32
+
+/* Syscalls whose first arg is a string (same numbers as x86_interrupts.S) */
+#define STRACE_SYS_EXECUTE  2
+#define STRACE_SYS_OPEN     5
+
+/* pcb_t.strace bits */
+#define STRACE_SELF         0x1             /* The process' syscalls are recorded */
+#define STRACE_CHILDREN     0x2             /* Processes it executes get STRACE_SELF | STRACE_CHILDREN */
+
+/* syscall_strace pid that means the caller's future children */
+#define STRACE_CHILDREN_PID -1
+
+#ifndef ASM
+
+/* One finished syscall as returned by KSTAT_STRACE */
+typedef struct strace_rec {
+    uint32_t seq;                           /* Counts up by one per record, a gap means records were overwritten */
+    uint32_t pid;
+    uint32_t num;
+    uint32_t args[3];
+    int32_t ret;
+    uint32_t usec;                          /* Time from entry to return, including time spent blocked */
+    char str[STRACE_STR_LEN];               /* First arg as a string for execute/open, empty otherwise */
+} strace_rec_t;
+
+/* Called by sysstat_enter for traced processes, keeps the args in the PCB until the call ends */
+extern void strace_enter(uint32_t pid, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+/* Called by sysstat_finish for traced processes, appends the finished call to the ring */
+extern void strace_record(uint32_t pid, int32_t ret, uint64_t cycles);
+
+/* Sets or clears tracing of pid (STRACE_CHILDREN_PID for the caller's future children) */
+extern int32_t strace_set(int32_t pid, int32_t on);
+
+/* Moves up to count unread records into recs, oldest first, returns how many */
+extern int32_t strace_read(strace_rec_t* recs, int32_t count);
+
+#endif /* _STRACE_H */
+
+#endif /* ASM */
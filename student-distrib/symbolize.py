@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Symbolizes a profiler dump captured from the serial port.
+
+Run the kernel with the serial port going to a file (qemu ... -serial
+file:serial.log), run "prof <command>" in the OS, then:
+
+    ./symbolize.py serial.log                # flat profile
+    ./symbolize.py --folded serial.log > out.folded
+    flamegraph.pl out.folded > out.svg       # from the FlameGraph repo
+
+Kernel samples are resolved against bootimg, user samples against
+../syscalls/<program>.exe (the ELF from before elfconvert). There are no
+call stacks, so the folded output is just program;kernel|user;function.
+"""
+
+import argparse
+import bisect
+import collections
+import os
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+class Symbols:
+    """Function symbols of one ELF, looked up by address."""
+
+    def __init__(self, path):
+        self.addrs = []
+        self.names = []
+        if not os.path.exists(path):
+            return
+        out = subprocess.run(["nm", "-n", "--defined-only", path],
+                             capture_output=True, text=True, check=True).stdout
+        for line in out.splitlines():
+            parts = line.split()
+            if len(parts) != 3 or parts[1] not in "tTwW":
+                continue
+            self.addrs.append(int(parts[0], 16))
+            self.names.append(parts[2])
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i < 0:
+            return "0x%x" % addr
+        return self.names[i]
+
+
+def read_dump(path):
+    """Returns (pid -> [(first sample, program)], [(pid, cpl, eip)]) of the last dump in the log."""
+    execs, samples = None, None
+    with open(path, errors="replace") as f:
+        for line in f:
+            parts = line.split()
+            if parts[:2] == ["profile", "begin"]:
+                execs, samples = collections.defaultdict(list), []
+            elif samples is None:
+                continue
+            elif parts[:1] == ["exec"] and len(parts) == 4:
+                execs[int(parts[2])].append((int(parts[1]), parts[3]))
+            elif parts[:1] == ["sample"] and len(parts) == 5:
+                samples.append((int(parts[1]), int(parts[2]), int(parts[3], 16)))
+    if samples is None:
+        sys.exit("%s: no profile dump found" % path)
+    return execs, samples
+
+
+def program_of(execs, pid, index):
+    """Program pid was running when sample number index was taken."""
+    name = "pid%d" % pid
+    for first, prog in execs.get(pid, []):
+        if first > index:
+            break
+        name = prog
+    return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", help="serial port log holding a profile dump")
+    parser.add_argument("--folded", action="store_true",
+                        help="print folded stacks for flamegraph.pl instead of a flat profile")
+    parser.add_argument("--kernel", default=os.path.join(HERE, "bootimg"))
+    parser.add_argument("--programs", default=os.path.join(HERE, "..", "syscalls"),
+                        help="directory holding the user <program>.exe files")
+    args = parser.parse_args()
+
+    execs, samples = read_dump(args.log)
+    kernel = Symbols(args.kernel)
+    programs = {}
+    counts = collections.Counter()
+
+    for index, (pid, cpl, eip) in enumerate(samples):
+        prog = program_of(execs, pid, index)
+        if cpl == 0:
+            counts[(prog, "kernel", kernel.lookup(eip))] += 1
+        else:
+            if prog not in programs:
+                programs[prog] = Symbols(os.path.join(args.programs, prog + ".exe"))
+            counts[(prog, "user", programs[prog].lookup(eip))] += 1
+
+    if args.folded:
+        for key, count in sorted(counts.items()):
+            print("%s %d" % (";".join(key), count))
+        return
+
+    total = len(samples)
+    print("%d samples" % total)
+    print("%7s %6s  %-10s %-6s %s" % ("samples", "%", "program", "mode", "function"))
+    for (prog, mode, func), count in counts.most_common():
+        print("%7d %5.1f%%  %-10s %-6s %s" % (count, 100.0 * count / total, prog, mode, func))
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,7 @@
 */
 
 #include "syscall.h"
+#include "terminal.h"
 
 /* syscall_halt
  * 
@@ -17,8 +18,15 @@ int32_t syscall_halt (uint8_t status) {
     /* cli for critical section */
     cli();
 
+    /* Programs that switch the terminal to raw or non-blocking input don't have to switch it back,
+     * the parent gets the mode it had when this process first changed it */
+    if (pcbs[curr_pid]->saved_mode != -1) terminal_set_mode(terminal_active, pcbs[curr_pid]->saved_mode);
+
     /* Check if we are trying to halt a base shell */
     if (curr_pid == base_processes[terminal_active]) {
+        trace_record(TRACE_HALT, curr_pid, -1, status);
+        sysstat_finish(curr_pid, status);
+
         /* Make sure that base PID gets picked up again when going through execute */
         pcbs[curr_pid]->in_use = 0;
 
@@ -34,12 +42,19 @@ int32_t syscall_halt (uint8_t status) {
         /* Set up variables for context switch */
         uint32_t from_pid = curr_pid;
         uint32_t to_pid = pcbs[from_pid]->parent_pid;
+        trace_record(TRACE_HALT, from_pid, to_pid, status);
+        sysstat_finish(from_pid, status);
+        acct_charge();
+        irqstat_switch();
+        acct_reap(from_pid, to_pid);
         curr_pid = to_pid;
         pcbs[from_pid]->in_use = 0;
+        timer_del(&sleep_timers[from_pid]);
         tss.esp0 = (uint32_t)get_pstack_loc(to_pid);
 
         /* Update scheduler */
         active_processes[terminal_active] = to_pid;
+        vdso_set_current(to_pid, terminal_active);
 
         /* Close current fd associated with the executable that was called from shell */
         close(pcbs[to_pid]->curr_executable_fd);
@@ -179,14 +194,19 @@ int32_t syscall_execute (const uint8_t* command) {
         /* Close shell in fda */
         close(fd);
 
-        /* Initialize the pcb corresponding to the shell */
+        /* Initialize the pcb corresponding to the shell (charge whoever ran before it first) */
+        acct_charge();
+        irqstat_switch();
         init_pcb(child_pid);
         pcbs[child_pid]->pid = child_pid;
         pcbs[child_pid]->parent_pid = -1;
         pcbs[child_pid]->curr_executable_fd = -1;
         pcbs[child_pid]->shell = 1;
         strcpy(pcbs[child_pid]->args, "");
+        strcpy(pcbs[child_pid]->name, command_name);
+        pcbs[child_pid]->image_size = bytes_read;
         pcbs[child_pid]->terminal = terminal_active;
+        pcbs[child_pid]->nice = NICE_DEFAULT;
 
         /* Update active processes in scheduler */
         base_processes[terminal_active] = child_pid;
@@ -206,6 +226,11 @@ int32_t syscall_execute (const uint8_t* command) {
         /* COMMENT TO READ PRINTS */
         //clear();
 
+        vdso_set_current(child_pid, terminal_active);
+        trace_record(TRACE_EXECUTE, child_pid, -1, terminal_active);
+        profile_exec(child_pid, command_name);
+        acct_switch(ACCT_USER);
+
         /* Context switch to shell from temp variables (we won't be returning back here) */
         saved_regs_t temp_registers = (saved_regs_t){0};
         exec_context_switch(&temp_registers, &(pcbs[child_pid]->curr_regs));
@@ -214,13 +239,20 @@ int32_t syscall_execute (const uint8_t* command) {
         /* Save parent PID */
         uint32_t parent_pid = curr_pid;
 
-        /* Initialize the pcb corresponding to the child program */
+        /* Initialize the pcb corresponding to the child program (charge the parent first) */
+        sysstat_finish(parent_pid, 0);
+        acct_charge();
+        irqstat_switch();
         init_pcb(child_pid);
         pcbs[child_pid]->pid = child_pid;
         pcbs[child_pid]->parent_pid = parent_pid;
         pcbs[parent_pid]->curr_executable_fd = fd;
         strcpy(pcbs[child_pid]->args, command_args);
+        strcpy(pcbs[child_pid]->name, command_name);
+        pcbs[child_pid]->image_size = bytes_read;
         pcbs[child_pid]->terminal = terminal_active;
+        pcbs[child_pid]->nice = pcbs[parent_pid]->nice;     /* Children inherit their parent's niceness */
+        if (pcbs[parent_pid]->strace) pcbs[child_pid]->strace = STRACE_SELF | STRACE_CHILDREN;
 
         /* Flag if new process is running a shell */
         if ((strncmp((const int8_t*)command_name, (const int8_t*)("shell"), MAX_FILE_NAME_LENGTH) == 0))
@@ -243,6 +275,11 @@ int32_t syscall_execute (const uint8_t* command) {
         /* COMMENT TO READ PRINTS */
         //clear();
 
+        vdso_set_current(child_pid, terminal_active);
+        trace_record(TRACE_EXECUTE, child_pid, parent_pid, terminal_active);
+        profile_exec(child_pid, command_name);
+        acct_switch(ACCT_USER);
+
         /* Context switch to child process from shell */
         exec_context_switch(&(pcbs[parent_pid]->curr_regs), &(pcbs[child_pid]->curr_regs));
     }
@@ -425,12 +462,210 @@ int32_t syscall_vidmap (uint8_t** screen_start) {
     /* Save information in PCB */
     pcbs[curr_pid]->vidmap = 1;
 
+    /* The program draws into the first page, stop the console from scrolling away from it */
+    console_park(terminal_active);
+
     /* Don't forget to flush... */
     flush_tlb();
     
     return 0;
 }
 
+/* syscall_nice
+ * 
+ * Reads and changes the scheduling priority (niceness) of a process. Any process can lower
+ * the priority of another one, but only raise its own or one of its descendants'.
+ * Inputs: pid - process to change, a negative pid means the calling process
+ *         inc - amount to add to the niceness (0 just reads it), result is clamped to [NICE_MIN, NICE_MAX]
+ * Outputs: NICE_BIAS - new niceness (always positive, higher means more CPU time), -1 if pid is invalid
+ *          or the caller may not raise its priority
+ */
+int32_t syscall_nice (int32_t pid, int32_t inc) {
+    int32_t p, depth;
+
+    if (pid < 0) pid = curr_pid;
+
+    /* Check if pid is out of range or not running anything */
+    if (pid >= PID_NUM || pcbs[pid]->in_use == 0) return -1;
+
+    /* Nothing past the full range of niceness changes anything, and this keeps the add below from overflowing */
+    if (inc < NICE_MIN - NICE_MAX) inc = NICE_MIN - NICE_MAX;
+    if (inc > NICE_MAX - NICE_MIN) inc = NICE_MAX - NICE_MIN;
+
+    /* Raising the priority is only allowed if pid is the caller or below it in the process tree */
+    if (inc < 0) {
+        for (p = pid, depth = 0; p != -1 && p != curr_pid && depth < PID_NUM; depth++) p = pcbs[p]->parent_pid;
+        if (p != curr_pid) return -1;
+    }
+
+    pcbs[pid]->nice = clamp_nice(pcbs[pid]->nice + inc);
+
+    return NICE_BIAS - pcbs[pid]->nice;
+}
+
+/* syscall_yield
+ * 
+ * Gives up the rest of the current time slice to the other terminals
+ * Inputs: None
+ * Outputs: 0
+ */
+int32_t syscall_yield (void) {
+    uint32_t flags;
+    cli_and_save(flags);
+
+    /* We come back here once the scheduler picks our terminal again */
+    schedule();
+
+    restore_flags(flags);
+    return 0;
+}
+
+/* sleep_wakeup
+ * 
+ * Timer callback that wakes up a process sleeping in syscall_sleep
+ * Inputs: pid - process to wake up
+ * Outputs: None
+ */
+static void sleep_wakeup (uint32_t pid) {
+    pcbs[pid]->sleeping = 0;
+    latency_wake(pcbs[pid]->terminal, LAT_SLEEP);
+    scheduler_wake(pcbs[pid]->terminal);
+}
+
+/* syscall_sleep
+ * 
+ * Puts the calling process to sleep for at least ms milliseconds. The process is skipped
+ * by the scheduler until its timer in the timer wheel fires.
+ * Inputs: ms - number of milliseconds to sleep (0 behaves like yield)
+ * Outputs: 0
+ */
+int32_t syscall_sleep (uint32_t ms) {
+    uint32_t flags;
+    uint32_t pid = curr_pid;    /* curr_pid changes while we are switched out */
+
+    if (ms == 0) return syscall_yield();
+
+    cli_and_save(flags);
+
+    /* +1 tick since we are already partway through the current one */
+    pcbs[pid]->sleeping = 1;
+    latency_wait(pcbs[pid]->terminal, LAT_SLEEP);
+    timer_add(&sleep_timers[pid], ms_to_ticks(ms) + 1, &sleep_wakeup, pid);
+
+    while (pcbs[pid]->sleeping) {
+        schedule();
+
+        /* Every terminal is asleep, wait for the next tick */
+        if (pcbs[pid]->sleeping) {
+            acct_switch(ACCT_IDLE);
+            sti();
+            asm volatile ("hlt");
+            cli();
+            acct_switch(ACCT_KERNEL);
+        }
+    }
+    latency_run(pcbs[pid]->terminal, LAT_SLEEP);
+
+    restore_flags(flags);
+    return 0;
+}
+
+/* syscall_clock_gettime
+ * 
+ * Reads the TSC based monotonic clock
+ * Inputs: ts - user buffer to fill with seconds and nanoseconds
+ * Outputs: 0 if successful, -1 if ts is not in the program image
+ */
+int32_t syscall_clock_gettime (timespec_t* ts) {
+    /* Check if pointer is valid and the whole struct is within program image range */
+    if (!ts || !((uint32_t)ts >= USR_PAGE && (uint32_t)ts + sizeof(timespec_t) <= USR_PAGE + BIG_PAGE_SIZE)) {
+        return -1;
+    }
+
+    clock_gettime(ts);
+    return 0;
+}
+
+/* syscall_getrusage
+ * 
+ * Reports CPU time used by the calling process or by its halted children
+ * Inputs: who - RUSAGE_SELF or RUSAGE_CHILDREN
+ *         ru - user buffer to fill with user and system time
+ * Outputs: 0 if successful, -1 if who or ru is invalid
+ */
+int32_t syscall_getrusage (int32_t who, rusage_t* ru) {
+    if (who != RUSAGE_SELF && who != RUSAGE_CHILDREN) return -1;
+
+    /* Check if pointer is valid and the whole struct is within program image range */
+    if (!ru || !((uint32_t)ru >= USR_PAGE && (uint32_t)ru + sizeof(rusage_t) <= USR_PAGE + BIG_PAGE_SIZE)) {
+        return -1;
+    }
+
+    acct_getrusage(curr_pid, who, ru);
+    return 0;
+}
+
+/* syscall_kstat
+ * 
+ * Copies out a snapshot of kernel statistics
+ * Inputs: which - KSTAT_* value picking what to report
+ *         buf - user buffer to fill
+ *         nbytes - size of buf
+ * Outputs: number of entries written, -1 if which or buf is invalid
+ */
+int32_t syscall_kstat (int32_t which, void* buf, int32_t nbytes) {
+    /* Check if pointer is valid and the whole buffer is within program image range */
+    if (!buf || nbytes < 0 || !((uint32_t)buf >= USR_PAGE && (uint32_t)buf + nbytes <= USR_PAGE + BIG_PAGE_SIZE)) {
+        return -1;
+    }
+
+    return kstat_read(which, buf, nbytes);
+}
+
+/* syscall_profile
+ * 
+ * Starts, stops or dumps the sampling profiler
+ * Inputs: cmd - PROFILE_START, PROFILE_STOP or PROFILE_DUMP
+ * Outputs: number of samples taken so far, -1 if cmd is invalid
+ */
+int32_t syscall_profile (int32_t cmd) {
+    return profile_ctl(cmd);
+}
+
+/* syscall_strace
+ * 
+ * Turns syscall tracing on or off, records are read back with KSTAT_STRACE
+ * Inputs: pid - process to trace (and whatever it executes), -1 for whatever the caller executes next
+ *         on - nonzero to start tracing, 0 to stop
+ * Outputs: 0 if successful, -1 if pid is invalid
+ */
+int32_t syscall_strace (int32_t pid, int32_t on) {
+    return strace_set(pid, on);
+}
+
+/* syscall_trace
+ * 
+ * Starts or stops recording kernel trace events, they are read back with KSTAT_TRACE
+ * Inputs: cmd - TRACE_START or TRACE_STOP
+ * Outputs: 0 if successful, -1 if cmd is invalid
+ */
+int32_t syscall_trace (int32_t cmd) {
+    return trace_ctl(cmd);
+}
+
+/* syscall_ioctl
+ * 
+ * Device specific control, only the terminal (stdin/stdout) has any
+ * Inputs: fd - 0 or 1
+ *         cmd - TERM_GETMODE or TERM_SETMODE
+ *         arg - depends on cmd
+ * Outputs: depends on cmd, -1 if fd or cmd is invalid
+ */
+int32_t syscall_ioctl (int32_t fd, int32_t cmd, uint32_t arg) {
+    if ((fd != FD_STDIN_IDX && fd != FD_STDOUT_IDX) || !fda_spaces[curr_pid][fd]) return -1;
+    return terminal_ioctl(cmd, arg);
+}
+
 int32_t syscall_set_handler (int32_t signum, void* handler_address) {
     printf("SYSCALL SET HANDLER, Parameters -> signum: %d, handler_addr: %x", signum, handler_address);
     return 0;
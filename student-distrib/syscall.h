@@ -10,6 +10,16 @@
 #include "filesystem.h"
 #include "paging.h"
 #include "lib.h"
+#include "clock.h"
+#include "vdso.h"
+#include "acct.h"
+#include "kstat.h"
+#include "latency.h"
+#include "trace.h"
+#include "profile.h"
+#include "irqstat.h"
+#include "sysstat.h"
+#include "strace.h"
 
 #ifndef ASM
 
@@ -25,6 +35,17 @@ extern int32_t syscall_set_handler (int32_t signum, void* handler_address);
 extern int32_t syscall_sigreturn (void);
 extern void* syscall_malloc (int32_t size);
 extern void syscall_free (void* ptr);
+/* Returns NICE_BIAS - niceness (not the niceness itself) so that -1 is free for errors */
+extern int32_t syscall_nice (int32_t pid, int32_t inc);
+extern int32_t syscall_yield (void);
+extern int32_t syscall_sleep (uint32_t ms);
+extern int32_t syscall_clock_gettime (timespec_t* ts);
+extern int32_t syscall_getrusage (int32_t who, rusage_t* ru);
+extern int32_t syscall_kstat (int32_t which, void* buf, int32_t nbytes);
+extern int32_t syscall_profile (int32_t cmd);
+extern int32_t syscall_strace (int32_t pid, int32_t on);
+extern int32_t syscall_ioctl (int32_t fd, int32_t cmd, uint32_t arg);
+extern int32_t syscall_trace (int32_t cmd);
 
 extern int32_t halt (uint8_t status);
 extern int32_t execute (const uint8_t* command);
@@ -0,0 +1,106 @@
+/* sysstat.c - Per-syscall counters and latencies
+ * vim:ts=4 noexpandtab
+ *
+ * A syscall's time runs from syscall_jmp to sys_finish, including any time it spends
+ * blocked (read waiting for a line, sleep). The start is kept in the caller's PCB since
+ * blocking calls switch stacks. execute is ended when the child starts instead of when
+ * the child halts, and halt when it switches back to the parent. Syscalls the kernel
+ * makes itself (execute("shell"), close() in halt) have a kernel cs and aren't counted.
+ * Traced processes (see strace.c) also get each call recorded on the way out.
+ */
+
+#include "sysstat.h"
+#include "lib.h"
+#include "clock.h"
+#include "pid.h"
+#include "strace.h"
+
+static sys_count_t sys_counts[SYSSTAT_CALLS];
+
+/* sysstat_enter
+ * 
+ * Inputs: num - syscall number from eax
+ *         arg1, arg2, arg3 - ebx, ecx and edx
+ *         cs - code segment the int 0x80 came from
+ * Outputs: None
+ */
+void sysstat_enter(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t cs) {
+    pcb_t* pcb;
+
+    if ((cs & SYSSTAT_CPL_MASK) == 0 || num == SYSSTAT_NONE || num >= SYSSTAT_CALLS) return;
+
+    pcb = pcbs[curr_pid];
+    pcb->sys_num = num;
+    pcb->sys_start = tsc_khz ? rdtsc() : 0;
+    if (pcb->strace & STRACE_SELF) strace_enter(curr_pid, arg1, arg2, arg3);
+}
+
+/* sysstat_exit
+ * 
+ * Inputs: ret - value being returned to the caller
+ *         cs - code segment the int 0x80 came from
+ * Outputs: None
+ */
+void sysstat_exit(int32_t ret, uint32_t cs) {
+    if ((cs & SYSSTAT_CPL_MASK) == 0) return;
+    sysstat_finish(curr_pid, ret);
+}
+
+/* sysstat_finish
+ * 
+ * Inputs: pid - process whose syscall is done
+ *         ret - value it returns
+ * Outputs: None
+ */
+void sysstat_finish(uint32_t pid, int32_t ret) {
+    pcb_t* pcb = pcbs[pid];
+    sys_count_t* sc;
+    uint64_t cycles;
+
+    if (pcb->sys_num == SYSSTAT_NONE) return;
+
+    cycles = tsc_khz ? rdtsc() - pcb->sys_start : 0;
+    sc = &sys_counts[pcb->sys_num];
+    sc->count++;
+    sc->cycles += cycles;
+    if (cycles > sc->max_cycles) sc->max_cycles = cycles;
+    if (pcb->strace & STRACE_SELF) strace_record(pid, ret, cycles);
+
+    pcb->sys_num = SYSSTAT_NONE;
+}
+
+/* sysstat_read
+ * 
+ * Inputs: stats - array to fill
+ *         count - number of entries stats has room for
+ * Outputs: number of entries written
+ */
+int32_t sysstat_read(sys_stat_t* stats, int32_t count) {
+    uint32_t flags;
+    uint32_t num;
+    int32_t n = 0;
+    uint64_t t;
+
+    cli_and_save(flags);
+    for (num = 0; num < SYSSTAT_CALLS && n < count; num++) {
+        if (sys_counts[num].count == 0) continue;
+
+        stats[n].num = num;
+        stats[n].count = sys_counts[num].count;
+
+        t = cycles_to_ns(sys_counts[num].cycles);
+        div64_32(&t, NS_PER_MS / US_PER_MS);
+        stats[n].total_us = (uint32_t)t;
+
+        t = sys_counts[num].cycles;
+        div64_32(&t, sys_counts[num].count);
+        stats[n].avg_cycles = (uint32_t)t;
+
+        t = sys_counts[num].max_cycles;
+        stats[n].max_cycles = (t >> 32) ? 0xFFFFFFFF : (uint32_t)t;
+        n++;
+    }
+    restore_flags(flags);
+
+    return n;
+}
@@ -0,0 +1,51 @@
+/* sysstat.h - Per-syscall counters and latencies
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _SYSSTAT_H
+#define _SYSSTAT_H
+
+#include "types.h"
+
+/* Syscall numbers that get counted (at least MAX_SYS + 1 from x86_interrupts.S) */
+#define SYSSTAT_CALLS       32
+
+/* pcb_t.sys_num when the process isn't in a syscall (0 is never a valid syscall) */
+#define SYSSTAT_NONE        0
+
+/* Code segment privilege bits, only syscalls made from user space are counted */
+#define SYSSTAT_CPL_MASK    0x3
+
+#ifndef ASM
+
+/* Totals for one syscall number */
+typedef struct sys_count {
+    uint32_t count;
+    uint64_t cycles;                        /* TSC cycles from entry to return */
+    uint64_t max_cycles;
+} sys_count_t;
+
+/* One syscall as returned by KSTAT_SYSCALL */
+typedef struct sys_stat {
+    uint32_t num;
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;                    /* 0xFFFFFFFF if it doesn't fit */
+} sys_stat_t;
+
+/* Called by syscall_jmp with the syscall number, its args and the caller's cs */
+extern void sysstat_enter(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t cs);
+
+/* Called by sys_finish with the return value and the caller's cs */
+extern void sysstat_exit(int32_t ret, uint32_t cs);
+
+/* Ends pid's syscall now, for calls that don't return through sys_finish (execute, halt) */
+extern void sysstat_finish(uint32_t pid, int32_t ret);
+
+/* Fills stats with the syscalls that have been made, lowest number first, returns how many */
+extern int32_t sysstat_read(sys_stat_t* stats, int32_t count);
+
+#endif /* _SYSSTAT_H */
+
+#endif /* ASM */
@@ -8,8 +8,12 @@
 #include "kboard.h"
 #include "pid.h"
 #include "scheduler.h"
+#include "latency.h"
 
-static void clear_keyboard_buf();
+static void clear_keyboard_buf(int32_t terminal);
+static int32_t terminal_read_raw(uint8_t* buf, int32_t nbytes);
+static uint8_t key_pop(terminal_t* term);
+static int32_t wait_key(int32_t terminal);
 
 /* int terminal_open()
  * Inputs: None
@@ -100,26 +104,37 @@ int32_t terminal_close(int32_t fd) {
 
 /* int terminal_read(int32_t fd, char *buf, uint32_t nbytes);
  * Inputs: uint32_t fd, char *buf, uint32_t nbytes
- * Return Value: number of bytes copied
- * Function: reads from the terminal/keyboard buffer */
+ * Return Value: number of bytes copied, 0 if the terminal is TERM_NONBLOCK and no line is done
+ * Function: reads a line from the keyboard. Keys are taken from the terminal's key ring and
+ *           edited into the keyboard buffer (with echo) until enter, so keys typed before
+ *           the read are not lost */
 int32_t terminal_read(int32_t fd, void *buf, int32_t nbytes) {
     
     uint8_t *buffer = buf;
+    terminal_t* term = &terminal_ctx[terminal_active];
     int i;
     
 
     if (fd != 0 || buffer == 0) {
         return -1;
     }
-    
-    clear_keyboard_buf();
 
-    // wait to see if user has pressed enter or if the buffer is filled
-    while(!terminal_ctx[terminal_active].enter_flag) {
-       continue;    
+    if (term->mode & TERM_RAW) {
+        return terminal_read_raw(buffer, nbytes);
     }
 
     uint32_t flags;
+
+    // edit keys into the buffer until the user presses enter or the buffer is filled
+    while (!term->enter_flag) {
+        /* Polling for a line, keep what has been typed of it so far */
+        if (!wait_key(terminal_active)) return 0;
+
+        cli_and_save(flags);
+        edit_line(key_pop(term));
+        restore_flags(flags);
+    }
+
     cli_and_save(flags);
     /* we are here if enter flag = 1 so we copy the keyboard buffer to our buf */
     
@@ -134,10 +149,10 @@ int32_t terminal_read(int32_t fd, void *buf, int32_t nbytes) {
     temp = buffer; // this is so we dont lose the initial address of buf
 
     for (i = 0; i < nbytes; i++, temp++) {
-        if (terminal_ctx[terminal_active].keyboard_buf[i] == '\0') {
+        if (term->keyboard_buf[i] == '\0') {
             break;
         }
-        *temp = (uint8_t)(terminal_ctx[terminal_active].keyboard_buf[i]);
+        *temp = (uint8_t)(term->keyboard_buf[i]);
         copied++;   
     }
     success = copied;
@@ -149,9 +164,9 @@ int32_t terminal_read(int32_t fd, void *buf, int32_t nbytes) {
         temp++;
     }
 
-    clear_keyboard_buf();
+    clear_keyboard_buf(terminal_active);
 
-    terminal_ctx[terminal_active].enter_flag = 0;
+    term->enter_flag = 0;
     restore_flags(flags);
 
     return success;
@@ -172,22 +187,145 @@ int32_t terminal_write(int32_t fd, const void *buf, int32_t nbytes) {
     if (!buffer) {
         return -1;
     }
-   
-    int i;  
-    int copied = 0;
 
-    for (i = 0; i < nbytes; i++) {
-        // check here for null bytes
-        if (buffer[i]) {
-            putc(buffer[i]);
-        }
-        copied++;
+    if (nbytes <= 0) {
+        return 0;
     }
-    
+   
+    /* One critical section and one cursor update for the whole buffer */
+    putbuf(buffer, nbytes);
+
     terminal_x = 0;
     
-    return copied;
+    return nbytes;
+}
+/* int32_t terminal_read_raw(uint8_t* buf, int32_t nbytes);
+ * Inputs: buf - user buffer, nbytes - size of buf
+ * Return Value: number of bytes copied, 0 if there is no input and the terminal is TERM_NONBLOCK
+ * Function: reads keys as they come in, without echo or waiting for enter. Waits for the
+ *           first key and then takes whatever else is queued that fits. The arrow keys
+ *           come out as ESC [ A / ESC [ B and are dropped if buf can't hold them */
+static int32_t terminal_read_raw(uint8_t* buf, int32_t nbytes) {
+    terminal_t* term = &terminal_ctx[terminal_active];
+    int32_t n = 0;
+    uint8_t key;
+
+    if (nbytes <= 0 || !wait_key(terminal_active)) return 0;
+
+    while (term->key_tail != term->key_head) {
+        key = term->key_ring[term->key_tail & KEY_RING_MASK];
+        if (key == KEY_UP || key == KEY_DOWN) {
+            if (n + 3 > nbytes) {
+                if (n) break;
+                key_pop(term);
+                continue;
+            }
+            buf[n++] = 0x1B;
+            buf[n++] = '[';
+            buf[n++] = (key == KEY_UP) ? 'A' : 'B';
+        } else {
+            if (n == nbytes) break;
+            buf[n++] = key;
+        }
+        key_pop(term);
+    }
+
+    return n;
+}
+
+/* void terminal_key_push(int32_t terminal, uint8_t key);
+ * Inputs: terminal - terminal the key was typed in, key - char or KEY_UP/KEY_DOWN
+ * Return Value: None
+ * Function: queues a key for the terminal's reader. The key ring is single producer
+ *           (this, from the keyboard handler) single consumer (the terminal's reader),
+ *           each side only writes its own index so neither needs a lock. The key goes
+ *           in before key_head moves past it */
+void terminal_key_push(int32_t terminal, uint8_t key) {
+    terminal_t* term = &terminal_ctx[terminal];
+    uint32_t head = term->key_head;
+
+    /* Full, the reader is too far behind */
+    if (head - term->key_tail == KEY_RING_SIZE) return;
+
+    term->key_ring[head & KEY_RING_MASK] = key;
+    asm volatile ("" : : : "memory");
+    term->key_head = head + 1;
+
+    /* Let a reader blocked on this key run right away. In line mode it only needs to run
+     * early for the key that ends the line, so held keys and type-ahead don't keep boosting */
+    latency_wake(terminal, LAT_KEYBOARD);
+    if (term->key_waiting && ((term->mode & TERM_RAW) || key == '\n')) scheduler_boost(terminal);
+}
+
+/* static uint8_t key_pop(terminal_t* term);
+ * Inputs: term - reader's terminal, its key ring must not be empty
+ * Return Value: the oldest queued key
+ * Function: takes a key off the key ring, the slot is read before key_tail gives it back */
+static uint8_t key_pop(terminal_t* term) {
+    uint32_t tail = term->key_tail;
+    uint8_t key = term->key_ring[tail & KEY_RING_MASK];
+
+    asm volatile ("" : : : "memory");
+    term->key_tail = tail + 1;
+    return key;
+}
+
+/* static int32_t wait_key(int32_t terminal);
+ * Inputs: terminal - reader's terminal
+ * Return Value: 1 once a key is queued, 0 if none is and the terminal is TERM_NONBLOCK
+ * Function: waits for the keyboard handler to queue a key */
+static int32_t wait_key(int32_t terminal) {
+    terminal_t* term = &terminal_ctx[terminal];
+
+    if (term->key_tail != term->key_head) return 1;
+    if (term->mode & TERM_NONBLOCK) return 0;
+
+    latency_wait(terminal, LAT_KEYBOARD);
+    term->key_waiting = 1;
+    while (term->key_tail == term->key_head) {
+        continue;
+    }
+    term->key_waiting = 0;
+    latency_run(terminal, LAT_KEYBOARD);
+    return 1;
+}
+
+/* int32_t terminal_ioctl(int32_t cmd, uint32_t arg);
+ * Inputs: cmd - TERM_GETMODE or TERM_SETMODE
+ *         arg - new mode bits for TERM_SETMODE
+ * Return Value: the mode for TERM_GETMODE, 0 for TERM_SETMODE, -1 if cmd or arg is invalid
+ * Function: gets or sets the input mode of the caller's terminal */
+int32_t terminal_ioctl(int32_t cmd, uint32_t arg) {
+    switch (cmd) {
+        case TERM_GETMODE:
+            return terminal_ctx[terminal_active].mode;
+        case TERM_SETMODE:
+            if (arg & ~TERM_MODES) return -1;
+            /* Remember what the parent was using, halt puts it back */
+            if (pcbs[curr_pid]->saved_mode == -1) pcbs[curr_pid]->saved_mode = terminal_ctx[terminal_active].mode;
+            terminal_set_mode(terminal_active, arg);
+            return 0;
+        default:
+            return -1;
+    }
 }
+
+/* void terminal_set_mode(int32_t terminal, uint32_t mode);
+ * Inputs: terminal - terminal to change, mode - TERM_RAW/TERM_NONBLOCK bits
+ * Return Value: None
+ * Function: sets the terminal's input mode. A line that was being typed is dropped (without
+ *           erasing it from the screen), keys still in the key ring are kept for the new mode */
+void terminal_set_mode(int32_t terminal, uint32_t mode) {
+    uint32_t flags;
+    cli_and_save(flags);
+    if (terminal_ctx[terminal].mode != mode) {
+        clear_keyboard_buf(terminal);
+        terminal_ctx[terminal].enter_flag = 0;
+        terminal_ctx[terminal].mode = mode;
+    }
+    restore_flags(flags);
+}
+
 /* int32_t bad_read();
  * Inputs: None
  * Return Value: None
@@ -195,22 +333,11 @@ int32_t terminal_write(int32_t fd, const void *buf, int32_t nbytes) {
 int32_t bad_read() {
     return -1;
 }
-/* clear_keyboard_buf();
- * Inputs: None
+/* clear_keyboard_buf(int32_t terminal);
+ * Inputs: terminal - terminal whose line to throw away
  * Return Value: None
- * Function: clears the keyboard buffer and resets its index */
-static void clear_keyboard_buf() {
-    uint32_t flags;
-    cli_and_save(flags);
-    int i;
-    for (i = 0; i < BUF_SIZE; i++) {
-        if (terminal_ctx[terminal_active].keyboard_buf[i]) {
-            terminal_ctx[terminal_active].keyboard_buf[i] = 0;
-            putc('\b');
-        }
-    }
-
-    terminal_ctx[terminal_active].buf_idx = 0;
-    
-    restore_flags(flags);
+ * Function: clears the keyboard buffer and resets its index, what was echoed stays on the screen */
+static void clear_keyboard_buf(int32_t terminal) {
+    memset(terminal_ctx[terminal].keyboard_buf, 0, BUF_SIZE);
+    terminal_ctx[terminal].buf_idx = 0;
 }
@@ -4,6 +4,7 @@
 
 #include "types.h"
 #include "kboard.h"
+#include "scrollback.h"
 
 /* define indices of stdin and stdout for fd*/
 #define FD_STDIN_IDX 0
@@ -11,17 +12,34 @@
 
 #define NUM_TERMINALS 3
 
+/* terminal_ioctl commands */
+#define TERM_GETMODE    0               /* Returns the terminal's mode bits */
+#define TERM_SETMODE    1               /* Sets them to arg */
+
+/* Mode bits, 0 is the normal line at a time input */
+#define TERM_RAW        0x1             /* Reads get each key as it is pressed, nothing is echoed or edited */
+#define TERM_NONBLOCK   0x2             /* Reads return 0 right away if there is no input (a line when not raw) */
+#define TERM_MODES      (TERM_RAW | TERM_NONBLOCK)
+
+/* Keys queued per terminal (power of 2), key presses past that are dropped until the reader catches up */
+#define KEY_RING_SIZE   256
+#define KEY_RING_MASK   (KEY_RING_SIZE - 1)
+
 /* Terminal Struct to keep track of state per terminal */
 typedef struct {
     uint8_t keyboard_buf[BUF_SIZE];
     saved_command_t saved_commands[SAVED_COMMANDS_SIZE];
     int32_t curr_scommands_idx;
     int32_t top_scommands_idx;
-    uint8_t buf_idx;
-    uint32_t screen_x;
-    uint32_t screen_y;
+    volatile uint8_t buf_idx;
     uint32_t terminal_x;
     volatile uint32_t enter_flag;
+    uint32_t mode;                      /* TERM_RAW/TERM_NONBLOCK, a halting program puts back its parent's mode */
+    uint8_t key_ring[KEY_RING_SIZE];    /* Keys the keyboard handler queued (chars, KEY_UP/KEY_DOWN) */
+    volatile uint32_t key_head;         /* Keys ever queued, only the keyboard handler writes it */
+    volatile uint32_t key_tail;         /* Keys ever taken, only the reader writes it */
+    volatile uint32_t key_waiting;      /* Set while the reader is blocked in wait_key */
+    scrollback_t scrollback;            /* Lines that scrolled off the top of the console */
 } terminal_t;
 
 /* define for terminals */
@@ -39,6 +57,15 @@ extern int32_t terminal_read(int32_t fd, void *buf, int32_t nbytes);
 /* should take a string of chars with the number of characters to write*/
 extern int32_t terminal_write(int32_t fd, const void *buf, int32_t nbytes);
 
+/* queues a key press for the terminal's reader, called by the keyboard handler */
+extern void terminal_key_push(int32_t terminal, uint8_t key);
+
+/* gets or sets the terminal's input mode */
+extern int32_t terminal_ioctl(int32_t cmd, uint32_t arg);
+
+/* changes a terminal's input mode, throwing away any input not read yet */
+extern void terminal_set_mode(int32_t terminal, uint32_t mode);
+
 /* bad read */
 extern int32_t bad_read();
 
@@ -9,6 +9,9 @@
 #include "pid.h"
 #include "syscall.h"
 #include "pid.h"
+#include "timer.h"
+#include "clock.h"
+#include "scrollback.h"
 
 #define PASS 1
 #define FAIL 0
@@ -498,6 +501,385 @@ void sys_call_read_test(){
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* Scheduling tests */
+
+#define TIMER_TEST_COUNT	6
+
+static uint32_t timer_test_fired[TIMER_TEST_COUNT];
+
+/* Records the tick a test timer fired on */
+static void timer_test_callback(uint32_t idx) {
+	timer_test_fired[idx] = timer_ticks;
+}
+
+/* Timer Wheel Test
+ * 
+ * Arms timers on every level of the wheel (including ones that need to cascade)
+ * and checks that each one fires exactly on its expire tick
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Advances timer_ticks by a few thousand ticks
+ * Coverage: Timer wheel add/del/tick/cascade
+ * Files: timer.c/h
+ */
+int timer_wheel_test() {
+	TEST_HEADER;
+
+	int i;
+	int result = PASS;
+	uint32_t flags;
+	uint32_t start;
+	uint32_t delays[TIMER_TEST_COUNT] = {1, 63, 64, 65, 4095, 5000};
+	ktimer_t timers[TIMER_TEST_COUNT];
+	ktimer_t deleted;
+
+	cli_and_save(flags);
+	memset(timers, 0, sizeof(timers));
+	memset(&deleted, 0, sizeof(deleted));
+	start = timer_ticks;
+
+	for (i = 0; i < TIMER_TEST_COUNT; i++) {
+		timer_test_fired[i] = 0;
+		timer_add(&timers[i], delays[i], &timer_test_callback, i);
+	}
+
+	/* A deleted timer should never fire */
+	timer_add(&deleted, 10, &timer_test_callback, 0);
+	timer_del(&deleted);
+
+	while (timer_ticks - start <= delays[TIMER_TEST_COUNT - 1]) timer_tick();
+
+	for (i = 0; i < TIMER_TEST_COUNT; i++) {
+		if (timers[i].armed || timer_test_fired[i] != start + delays[i]) {
+			printf("Timer %d fired at +%d, expected +%d\n", i, timer_test_fired[i] - start, delays[i]);
+			result = FAIL;
+		}
+	}
+
+	restore_flags(flags);
+	return result;
+}
+
+/* TSC Clock Test
+ * 
+ * Checks the 64-bit helpers against known values and that the clock only moves forward
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: div64_32, mul_u64_u32_shr, clock_ns
+ * Files: lib.c/h, clock.c/h
+ */
+int tsc_clock_test() {
+	TEST_HEADER;
+
+	int i;
+	int result = PASS;
+	uint64_t n = 10000000000ULL;	/* 10 s in ns */
+	uint64_t prev, now;
+
+	if (div64_32(&n, NS_PER_SEC) != 0 || n != 10) result = FAIL;
+	n = 0x123456789ULL;
+	if (div64_32(&n, 0x10) != 0x9 || n != 0x12345678) result = FAIL;
+	if (mul_u64_u32_shr(0x100000000ULL, 3, 1) != 0x180000000ULL) result = FAIL;
+
+	if (tsc_khz == 0) {
+		printf("No TSC, clock is running on PIT ticks\n");
+		return result;
+	}
+
+	prev = clock_ns();
+	for (i = 0; i < 1000; i++) {
+		now = clock_ns();
+		if (now < prev) result = FAIL;
+		prev = now;
+	}
+
+	printf("TSC runs at %d kHz\n", tsc_khz);
+	return result;
+}
+
+
+#define KBD_TEST_KEYS	16
+#define KBD_TEST_PRESS	0x1E	/* 'a' */
+
+/* Keyboard Split Test
+ * 
+ * Times the keyboard top half (queueing a scancode, interrupts off) against the bottom
+ * half (decoding it, interrupts on) for the same scancodes and checks every key press
+ * made it to the shown terminal's key ring. The top half is what a keyboard interrupt
+ * now keeps interrupts off for, the decode used to run there too
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Drops whatever was in the shown terminal's key ring
+ * Coverage: keyboard_queue, keyboard_bottom_half
+ * Files: x86_inter.c/h
+ */
+int keyboard_split_test() {
+	TEST_HEADER;
+
+	int i;
+	int result = PASS;
+	uint32_t flags;
+	uint32_t keys;
+	uint64_t start, top, bottom;
+	terminal_t* term = &terminal_ctx[terminal_shown];
+
+	cli_and_save(flags);
+	term->key_tail = term->key_head;
+
+	start = rdtsc();
+	for (i = 0; i < KBD_TEST_KEYS; i++) {
+		if (keyboard_queue(KBD_TEST_PRESS) == -1) result = FAIL;
+		if (keyboard_queue(KBD_TEST_PRESS | 0x80) == -1) result = FAIL;
+	}
+	top = rdtsc() - start;
+
+	start = rdtsc();
+	keyboard_bottom_half();
+	bottom = rdtsc() - start;
+
+	keys = term->key_head - term->key_tail;
+	if (keys != KBD_TEST_KEYS) result = FAIL;
+	term->key_tail = term->key_head;
+	restore_flags(flags);
+
+	printf("Per scancode: %d cycles queueing (IF=0), %d cycles decoding (IF=1)\n",
+		(uint32_t)(top / (2 * KBD_TEST_KEYS)), (uint32_t)(bottom / (2 * KBD_TEST_KEYS)));
+	return result;
+}
+
+/* Key Boost Test
+ * 
+ * Pushes keys into the shown terminal's ring with and without a reader waiting and checks
+ * only the keys a waiting reader needs boost the terminal: '\n' in line mode, anything in
+ * raw mode. Needs the shown terminal's base shell to be running.
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Drops whatever was in the shown terminal's key ring
+ * Coverage: terminal_key_push, scheduler_boost
+ * Files: terminal.c/h, scheduler.c/h
+ */
+int key_boost_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	uint32_t flags;
+	uint32_t mode;
+	terminal_t* term = &terminal_ctx[terminal_shown];
+
+	cli_and_save(flags);
+	mode = term->mode;
+	term->mode = 0;
+	terminal_boost = -1;
+
+	/* Type-ahead, nobody is reading */
+	terminal_key_push(terminal_shown, '\n');
+	if (terminal_boost != -1) result = FAIL;
+
+	/* Line mode reader only wakes early for the end of the line */
+	term->key_waiting = 1;
+	terminal_key_push(terminal_shown, 'a');
+	if (terminal_boost != -1) result = FAIL;
+	terminal_key_push(terminal_shown, '\n');
+	if (terminal_boost != terminal_shown) result = FAIL;
+
+	/* Raw mode reader wants every key */
+	terminal_boost = -1;
+	term->mode = TERM_RAW;
+	terminal_key_push(terminal_shown, 'a');
+	if (terminal_boost != terminal_shown) result = FAIL;
+
+	term->key_waiting = 0;
+	term->key_tail = term->key_head;
+	term->mode = mode;
+	terminal_boost = -1;
+	restore_flags(flags);
+	return result;
+}
+
+/* Console tests */
+
+/* Console the console tests write to, it isn't shown at boot */
+#define CON_TEST_TERM	(TERMINAL_COUNT - 1)
+
+static console_t con_test_saved;
+static int con_test_saved_x;
+
+/* Feeds a string to the test console */
+static void con_test_write(const char* s) {
+	console_write(CON_TEST_TERM, (const uint8_t*)s, strlen((const int8_t*)s));
+}
+
+/* Cell at screen row y, column x of the test console */
+static uint16_t con_test_cell(int32_t y, int32_t x) {
+	console_t* c = &consoles[CON_TEST_TERM];
+	return c->cells[(c->top + y) % NUM_ROWS][x];
+}
+
+/* Feeds a string to a parser, returns what ansi_step said about its last byte */
+static int32_t ansi_test_feed(ansi_t* p, const char* s) {
+	int32_t r = ANSI_NONE;
+	while (*s) r = ansi_step(p, (uint8_t)*s++);
+	return r;
+}
+
+/* ANSI Parser Test
+ * 
+ * Runs malformed and interrupted sequences through the parser: a param past
+ * ANSI_PARAM_MAX, more params than ANSI_MAX_PARAMS, CAN and ESC in the middle of
+ * a sequence and a control character inside one
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: ansi_step, ansi_param
+ * Files: ansi.c/h
+ */
+int ansi_parser_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	ansi_t p;
+	memset(&p, 0, sizeof(p));
+
+	/* Huge params stop at ANSI_PARAM_MAX, the next one still parses */
+	if (ansi_test_feed(&p, "\x1b[123456;7H") != ANSI_CSI) result = FAIL;
+	if (ansi_param(&p, 0, 1) != ANSI_PARAM_MAX || ansi_param(&p, 1, 1) != 7) result = FAIL;
+
+	/* Params past ANSI_MAX_PARAMS are dropped, the first ones are kept */
+	if (ansi_test_feed(&p, "\x1b[1;2;3;4;5;6;7;8;9;10;;;11m") != ANSI_CSI) result = FAIL;
+	if (p.nparams != ANSI_MAX_PARAMS + 1) result = FAIL;
+	if (ansi_param(&p, ANSI_MAX_PARAMS - 1, 0) != ANSI_MAX_PARAMS) result = FAIL;
+	if (ansi_param(&p, ANSI_MAX_PARAMS, 0) != 0) result = FAIL;
+
+	/* CAN throws the sequence away, what follows is text */
+	if (ansi_test_feed(&p, "\x1b[12\x18") != ANSI_NONE || p.state != ANSI_GROUND) result = FAIL;
+	if (ansi_step(&p, 'A') != ANSI_PUT) result = FAIL;
+
+	/* ESC starts over with fresh params */
+	if (ansi_test_feed(&p, "\x1b[12;4\x1b[3B") != ANSI_CSI) result = FAIL;
+	if (p.nparams != 1 || ansi_param(&p, 0, 1) != 3) result = FAIL;
+
+	/* A control in the middle runs and the sequence carries on */
+	if (ansi_test_feed(&p, "\x1b[2") != ANSI_NONE || ansi_step(&p, '\n') != ANSI_PUT) result = FAIL;
+	if (ansi_test_feed(&p, ";5f") != ANSI_CSI || ansi_param(&p, 0, 1) != 2 || ansi_param(&p, 1, 1) != 5) result = FAIL;
+
+	return result;
+}
+
+/* Console ANSI Test
+ * 
+ * Writes escape sequences to a background console and checks the cells they leave:
+ * SGR colors, reverse and reset, and a CSI r scroll region with the cursor below it
+ * (line feeds there must not scroll the region or the screen)
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None, the console and terminal_x are put back afterwards
+ * Coverage: console_csi, console_sgr, scroll_region, line_feed
+ * Files: lib.c/h
+ */
+int console_ansi_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	console_t* c = &consoles[CON_TEST_TERM];
+
+	con_test_saved = *c;
+	con_test_saved_x = terminal_x;
+	con_test_write("\x1b" "c");
+
+	/* Red on blue, then reversed, then reset. Reverse of the default is black on red */
+	con_test_write("\x1b[31;44mA\x1b[7mB\x1b[0mC\x1b[0;7mD\x1b[mE");
+	if (con_test_cell(0, 0) != ((0x14 << 8) | 'A')) result = FAIL;
+	if (con_test_cell(0, 1) != ((0x41 << 8) | 'B')) result = FAIL;
+	if (con_test_cell(0, 2) != ((0x0C << 8) | 'C')) result = FAIL;
+	if (con_test_cell(0, 3) != ((0x40 << 8) | 'D')) result = FAIL;
+	if (con_test_cell(0, 4) != ((0x0C << 8) | 'E')) result = FAIL;
+
+	/* Rows 2-5 scroll, a bad region is ignored */
+	con_test_write("\x1b[2;5r\x1b[5;2r");
+	if (c->margin_top != 1 || c->margin_bottom != 4 || c->x != 0 || c->y != 0) result = FAIL;
+
+	/* Below the region line feeds just move down, and stop at the last row */
+	con_test_write("\x1b[11;1Hx\n\n");
+	if (c->y != 12) result = FAIL;
+	con_test_write("\x1b[25;1H\n\n");
+	if (c->y != NUM_ROWS - 1) result = FAIL;
+	if ((con_test_cell(0, 0) & 0xFF) != 'A' || (con_test_cell(10, 0) & 0xFF) != 'x') result = FAIL;
+
+	/* A line feed on the region's last row only scrolls the region */
+	con_test_write("\x1b[5;1HZ\n");
+	if (c->y != 4 || (con_test_cell(3, 0) & 0xFF) != 'Z' || (con_test_cell(4, 0) & 0xFF) != ' ') result = FAIL;
+	if ((con_test_cell(0, 0) & 0xFF) != 'A' || (con_test_cell(10, 0) & 0xFF) != 'x') result = FAIL;
+
+	*c = con_test_saved;
+	c->dirty = CON_ALL_ROWS;
+	terminal_x = con_test_saved_x;
+	return result;
+}
+
+#define SB_TEST_PUSHES	300
+#define SB_TEST_BLANK	0x0720
+
+static scrollback_t sb_test;
+
+/* Line number k of the scrollback test: every 8th line is blank, the rest change
+ * attribute every few cells and end in blanks at different columns */
+static void sb_test_line(uint32_t k, uint16_t* row) {
+	int32_t i;
+	int32_t len = 40 + k % 41;
+	int32_t run = 3 + k % 7;
+
+	for (i = 0; i < NUM_COLS; i++) {
+		if (k % 8 == 0 || i >= len) row[i] = SB_TEST_BLANK;
+		else row[i] = ((0x07 + (i / run) % 4) << 8) | ('a' + (k + i) % 26);
+	}
+}
+
+/* Scrollback Test
+ * 
+ * Pushes enough multi-run, partly blank and all blank lines to wrap the byte ring
+ * well before SCROLLBACK_LINES lines are kept, then reads every kept line back
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: scrollback_push/count/get, run length encoding, eviction by bytes
+ * Files: scrollback.c/h
+ */
+int scrollback_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	uint32_t k;
+	int32_t back, count, i;
+	uint16_t row[NUM_COLS], got[NUM_COLS];
+
+	memset(&sb_test, 0, sizeof(sb_test));
+	for (k = 0; k < SB_TEST_PUSHES; k++) {
+		sb_test_line(k, row);
+		scrollback_push(&sb_test, row, NUM_COLS, SB_TEST_BLANK);
+	}
+
+	/* The bytes ran out first and wrapped, and what is kept still fits */
+	count = scrollback_count(&sb_test);
+	if (count <= 0 || count >= SCROLLBACK_LINES || sb_test.data_head <= SCROLLBACK_BYTES) result = FAIL;
+	if (sb_test.data_head - sb_test.start[sb_test.tail & SCROLLBACK_LINES_MASK] > SCROLLBACK_BYTES) result = FAIL;
+
+	for (back = 1; back <= count; back++) {
+		sb_test_line(SB_TEST_PUSHES - back, row);
+		scrollback_get(&sb_test, back, got, NUM_COLS, SB_TEST_BLANK);
+		for (i = 0; i < NUM_COLS; i++) {
+			if (got[i] != row[i]) {
+				printf("Line %d col %d is %x, expected %x\n", SB_TEST_PUSHES - back, i, got[i], row[i]);
+				result = FAIL;
+				break;
+			}
+		}
+	}
+
+	printf("%d of %d lines kept in %d bytes\n", count, SB_TEST_PUSHES,
+		sb_test.data_head - sb_test.start[sb_test.tail & SCROLLBACK_LINES_MASK]);
+	return result;
+}
 
 /* Test suite entry point */
 void launch_tests(){
@@ -563,4 +945,15 @@ void launch_tests(){
 	//sys_call_exec_test();
 	// init_pcb(0);
 
+	/* Scheduling Tests */
+	// TEST_OUTPUT("timer_wheel_test", timer_wheel_test());
+	// TEST_OUTPUT("tsc_clock_test", tsc_clock_test());
+	// TEST_OUTPUT("keyboard_split_test", keyboard_split_test());
+	// TEST_OUTPUT("key_boost_test", key_boost_test());
+
+	/* Console Tests */
+	// TEST_OUTPUT("ansi_parser_test", ansi_parser_test());
+	// TEST_OUTPUT("console_ansi_test", console_ansi_test());
+	// TEST_OUTPUT("scrollback_test", scrollback_test());
+
 }
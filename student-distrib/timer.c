@@ -0,0 +1,180 @@
+/* timer.c - Hierarchical timer wheel driven by the PIT
+ * vim:ts=4 noexpandtab
+ */
+
+#include "timer.h"
+#include "pit.h"
+#include "lib.h"
+
+/* Local functions */
+static void internal_add(ktimer_t* timer);
+static uint32_t cascade(uint32_t level, uint32_t index);
+
+/* Ticks processed since boot, this is also the next slot the wheel will process */
+volatile uint32_t timer_ticks = 0;
+
+/* Slot heads for each level (circular doubly linked lists, a head pointing to itself is empty) */
+static ktimer_t wheel[TW_LEVELS][TW_SIZE];
+
+/* timer_init
+ * 
+ * Initializes every slot in the wheel to an empty list
+ * Inputs: None
+ * Outputs: None
+ */
+void timer_init() {
+    int i, j;
+    for (i = 0; i < TW_LEVELS; i++) {
+        for (j = 0; j < TW_SIZE; j++) {
+            wheel[i][j].next = &wheel[i][j];
+            wheel[i][j].prev = &wheel[i][j];
+        }
+    }
+    timer_ticks = 0;
+}
+
+/* internal_add
+ * 
+ * Puts a timer in the slot matching how far away its expire tick is. Timers close to
+ * expiring go in level 0 (one slot per tick), timers further away go in coarser levels
+ * and get moved down by cascade() as the wheel turns. Interrupts must be off.
+ * Inputs: timer - timer to insert, expires must already be set
+ * Outputs: None
+ */
+static void internal_add(ktimer_t* timer) {
+    uint32_t delta = timer->expires - timer_ticks;
+    ktimer_t* head;
+
+    /* Timers that are already due go in the slot that gets processed next */
+    if ((int32_t)delta < 0) {
+        head = &wheel[0][timer_ticks & TW_MASK];
+    } else {
+        uint32_t level = 0;
+
+        /* Clamp timers that are further away than the wheel can hold */
+        if (delta > TW_MAX_TICKS) {
+            delta = TW_MAX_TICKS;
+            timer->expires = timer_ticks + delta;
+        }
+
+        while (level < TW_LEVELS - 1 && delta >= (1 << (TW_BITS * (level + 1)))) level++;
+        head = &wheel[level][(timer->expires >> (TW_BITS * level)) & TW_MASK];
+    }
+
+    /* Insert at the tail of the slot */
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+/* cascade
+ * 
+ * Moves every timer from one slot of a coarse level into the finer levels
+ * Inputs: level - level of the slot to empty (1 and up)
+ *         index - slot to empty
+ * Outputs: index, so the caller knows if the next level has to cascade too (index 0)
+ */
+static uint32_t cascade(uint32_t level, uint32_t index) {
+    ktimer_t* head = &wheel[level][index];
+    ktimer_t* curr = head->next;
+    ktimer_t* next;
+
+    /* Empty the slot first since internal_add may not put timers back in it */
+    head->next = head;
+    head->prev = head;
+
+    while (curr != head) {
+        next = curr->next;
+        internal_add(curr);
+        curr = next;
+    }
+
+    return index;
+}
+
+/* timer_add
+ * 
+ * Arms a timer to fire after the given number of ticks, O(1)
+ * Inputs: timer - timer to arm (re-arming an armed timer moves it)
+ *         ticks - number of ticks from now until the timer fires
+ *         callback - function called when the timer fires
+ *         data - argument passed to callback
+ * Outputs: None
+ */
+void timer_add(ktimer_t* timer, uint32_t ticks, void (*callback)(uint32_t data), uint32_t data) {
+    uint32_t flags;
+    cli_and_save(flags);
+
+    if (timer->armed) timer_del(timer);
+
+    timer->expires = timer_ticks + ticks;
+    timer->callback = callback;
+    timer->data = data;
+    timer->armed = 1;
+    internal_add(timer);
+
+    restore_flags(flags);
+}
+
+/* timer_del
+ * 
+ * Disarms a timer if it hasn't fired yet, O(1)
+ * Inputs: timer - timer to disarm
+ * Outputs: None
+ */
+void timer_del(ktimer_t* timer) {
+    uint32_t flags;
+    cli_and_save(flags);
+
+    if (timer->armed) {
+        timer->prev->next = timer->next;
+        timer->next->prev = timer->prev;
+        timer->next = timer->prev = NULL;
+        timer->armed = 0;
+    }
+
+    restore_flags(flags);
+}
+
+/* timer_tick
+ * 
+ * Advances the wheel by one tick and fires every timer that expires on it.
+ * Called from the PIT handler with interrupts off.
+ * Inputs: None
+ * Outputs: None
+ */
+void timer_tick() {
+    uint32_t index = timer_ticks & TW_MASK;
+    uint32_t level;
+    ktimer_t* head;
+    ktimer_t* curr;
+
+    /* Level 0 wrapped around, pull the next slot of each coarser level down */
+    if (index == 0) {
+        for (level = 1; level < TW_LEVELS; level++)
+            if (cascade(level, (timer_ticks >> (TW_BITS * level)) & TW_MASK) != 0) break;
+    }
+
+    /* Fire everything in the current slot, callbacks are allowed to re-arm their timer */
+    head = &wheel[0][index];
+    while ((curr = head->next) != head) {
+        curr->prev->next = curr->next;
+        curr->next->prev = curr->prev;
+        curr->next = curr->prev = NULL;
+        curr->armed = 0;
+        curr->callback(curr->data);
+    }
+
+    timer_ticks++;
+}
+
+/* ms_to_ticks
+ * 
+ * Converts milliseconds to a number of ticks, rounded up
+ * Inputs: ms - milliseconds
+ * Outputs: number of ticks
+ */
+uint32_t ms_to_ticks(uint32_t ms) {
+    return (ms + PIT_TICK_MS - 1) / PIT_TICK_MS;
+}
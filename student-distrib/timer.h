@@ -0,0 +1,51 @@
+/* timer.h - Hierarchical timer wheel driven by the PIT
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include "types.h"
+
+/* Each level of the wheel has 64 slots, level n slots are 64^n ticks wide */
+#define TW_BITS         6
+#define TW_SIZE         (1 << TW_BITS)
+#define TW_MASK         (TW_SIZE - 1)
+#define TW_LEVELS       4
+
+/* Longest delay the wheel can hold (64^4 - 1 ticks), longer timers get clamped */
+#define TW_MAX_TICKS    ((1 << (TW_BITS * TW_LEVELS)) - 1)
+
+#ifndef ASM
+
+/* A timer that fires callback(data) once its expire tick is reached */
+typedef struct ktimer {
+    struct ktimer* next;                /* Next timer in the same slot */
+    struct ktimer* prev;                /* Previous timer in the same slot */
+    uint32_t expires;                   /* Tick count when the timer fires */
+    void (*callback)(uint32_t data);    /* Called from the PIT handler with interrupts off */
+    uint32_t data;                      /* Argument passed to callback */
+    int32_t armed;                      /* Shows if the timer is currently in the wheel (1 or 0) */
+} ktimer_t;
+
+/* Number of ticks processed by the wheel since boot */
+extern volatile uint32_t timer_ticks;
+
+/* Initializes every slot in the wheel to an empty list */
+extern void timer_init();
+
+/* Arms a timer to fire after the given number of ticks */
+extern void timer_add(ktimer_t* timer, uint32_t ticks, void (*callback)(uint32_t data), uint32_t data);
+
+/* Disarms a timer if it hasn't fired yet */
+extern void timer_del(ktimer_t* timer);
+
+/* Advances the wheel by one tick and fires expired timers, called by the PIT handler */
+extern void timer_tick();
+
+/* Converts milliseconds to a number of ticks, rounded up */
+extern uint32_t ms_to_ticks(uint32_t ms);
+
+#endif /* _TIMER_H */
+
+#endif /* ASM */
@@ -0,0 +1,136 @@
+/* trace.c - Per-CPU ring buffers of kernel trace events
+ * vim:ts=4 noexpandtab
+ *
+ * Each CPU only ever writes its own ring, so recording needs no lock: the slot is
+ * reserved with a non-locked xadd (a single instruction can't be split by an
+ * interrupt on the same CPU) and the record is published by its seq. Readers on any
+ * CPU check seq before and after copying a record, like a tiny seqlock, and drop it
+ * if the writer lapped them in between.
+ *
+ * Recording is off until a program asks for it (TRACE_START), so the tracepoints on the
+ * syscall, keyboard and tick paths only cost a load and a branch the rest of the time.
+ */
+
+#include "trace.h"
+#include "lib.h"
+#include "clock.h"
+#include "pid.h"
+
+#define barrier()   asm volatile ("" : : : "memory")
+
+trace_ring_t trace_rings[MAX_CPUS];
+volatile int32_t trace_enabled = 0;
+
+/* trace_record
+ * 
+ * Inputs: id - TRACE_* event id
+ *         arg0, arg1, arg2 - event specific values
+ * Outputs: None
+ */
+void trace_record(uint32_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2) {
+    trace_ring_t* ring;
+    trace_rec_t* rec;
+    uint32_t idx = 1;
+
+    /* rdtsc faults on CPUs without a TSC */
+    if (!trace_enabled || tsc_khz == 0) return;
+
+    ring = &trace_rings[smp_cpu_id()];
+    asm volatile ("xaddl %0, %1" : "+r"(idx), "+m"(ring->head) : : "memory", "cc");
+
+    rec = &ring->recs[idx & TRACE_RING_MASK];
+    rec->seq = 0;
+    barrier();
+    rec->id = id;
+    rec->tsc = rdtsc();
+    rec->pid = curr_pid;
+    rec->args[0] = arg0;
+    rec->args[1] = arg1;
+    rec->args[2] = arg2;
+    barrier();
+    rec->seq = idx + 1;
+}
+
+/* trace_ctl
+ * 
+ * Inputs: cmd - TRACE_START or TRACE_STOP
+ * Outputs: 0 if successful, -1 if cmd is invalid
+ */
+int32_t trace_ctl(int32_t cmd) {
+    uint32_t flags;
+    uint32_t cpu;
+
+    cli_and_save(flags);
+    switch (cmd) {
+        case TRACE_START:
+            /* Only trace_read moves tail, and it runs with interrupts off on the BSP too */
+            for (cpu = 0; cpu < MAX_CPUS; cpu++) trace_rings[cpu].tail = trace_rings[cpu].head;
+            trace_enabled = 1;
+            break;
+        case TRACE_STOP:
+            trace_enabled = 0;
+            break;
+        default:
+            restore_flags(flags);
+            return -1;
+    }
+    restore_flags(flags);
+    return 0;
+}
+
+/* trace_read
+ * 
+ * Only processes read the rings and they all run on the BSP, so masking interrupts
+ * is enough to keep two readers from moving the same tail
+ * Inputs: events - array to fill
+ *         count - number of entries events has room for
+ * Outputs: number of events written
+ */
+int32_t trace_read(trace_event_t* events, int32_t count) {
+    uint32_t flags;
+    uint32_t cpu, head, seq;
+    int32_t n = 0;
+    trace_ring_t* ring;
+    trace_rec_t* rec;
+    trace_event_t* ev;
+    uint64_t ns;
+
+    cli_and_save(flags);
+
+    for (cpu = 0; cpu < MAX_CPUS && n < count; cpu++) {
+        ring = &trace_rings[cpu];
+        head = ring->head;
+
+        /* Skip what got overwritten before we got to it */
+        if (head - ring->tail > TRACE_RING_SIZE) ring->tail = head - TRACE_RING_SIZE;
+
+        for (; ring->tail != head && n < count; ring->tail++) {
+            rec = &ring->recs[ring->tail & TRACE_RING_MASK];
+            seq = rec->seq;
+
+            /* Reserved but not written yet (an interrupted writer), try again next read */
+            if (seq == 0 || (int32_t)(seq - (ring->tail + 1)) < 0) break;
+
+            /* Lapped by the writer, the record is gone */
+            if (seq != ring->tail + 1) continue;
+
+            ev = &events[n];
+            ev->cpu = cpu;
+            ev->id = rec->id;
+            ev->pid = rec->pid;
+            ev->args[0] = rec->args[0];
+            ev->args[1] = rec->args[1];
+            ev->args[2] = rec->args[2];
+            ns = tsc_to_ns(rec->tsc);
+            barrier();
+            if (rec->seq != seq) continue;
+
+            ev->nsec = div64_32(&ns, NS_PER_SEC);
+            ev->sec = (uint32_t)ns;
+            n++;
+        }
+    }
+
+    restore_flags(flags);
+    return n;
+}
@@ -0,0 +1,75 @@
+/* trace.h - Per-CPU ring buffers of kernel trace events
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include "types.h"
+#include "smp.h"
+
+/* Records per CPU (power of 2), the oldest records get overwritten when a ring is full */
+#define TRACE_RING_SIZE     2048
+#define TRACE_RING_MASK     (TRACE_RING_SIZE - 1)
+
+/* Event ids and their args (x86_interrupts.S has its own copy of TRACE_SYSCALL) */
+#define TRACE_SCHED         1               /* old terminal, new terminal, new pid (-1 if its shell isn't started) */
+#define TRACE_SYSCALL       2               /* syscall number, first two args */
+#define TRACE_EXECUTE       3               /* new pid, parent pid (-1 for a base shell), terminal */
+#define TRACE_HALT          4               /* pid, pid returned to (-1 for a base shell), status */
+#define TRACE_RTC           5               /* bitmask of terminals whose virtual RTC ticked */
+#define TRACE_KEYBOARD      6               /* byte read from the keyboard, shown terminal */
+#define TRACE_TICK          7               /* scheduler tick count, TRACE_TICK_PIT or TRACE_TICK_LAPIC */
+
+#define TRACE_TICK_PIT      0
+#define TRACE_TICK_LAPIC    1
+
+/* Commands for the trace syscall */
+#define TRACE_START         0               /* Throws away unread events and starts recording */
+#define TRACE_STOP          1               /* Stops recording, unread events can still be read */
+
+#ifndef ASM
+
+/* One record as stored in the ring */
+typedef struct trace_rec {
+    volatile uint32_t seq;                  /* Ring index + 1 once the record is complete, 0 while it's being written */
+    uint32_t id;
+    uint64_t tsc;
+    uint32_t pid;                           /* curr_pid when the event happened */
+    uint32_t args[3];
+} trace_rec_t;
+
+/* Only the owning CPU writes head, only trace_read touches tail */
+typedef struct trace_ring {
+    volatile uint32_t head;                 /* Index of the next record to write */
+    uint32_t tail;                          /* Index of the next record to read */
+    trace_rec_t recs[TRACE_RING_SIZE];
+} trace_ring_t;
+
+/* One record as returned by KSTAT_TRACE */
+typedef struct trace_event {
+    uint32_t sec;                           /* Time since boot */
+    uint32_t nsec;
+    uint16_t cpu;
+    uint16_t id;
+    uint32_t pid;
+    uint32_t args[3];
+} trace_event_t;
+
+extern trace_ring_t trace_rings[MAX_CPUS];
+
+/* Set between TRACE_START and TRACE_STOP, trace_record does nothing otherwise */
+extern volatile int32_t trace_enabled;
+
+/* Appends an event to the calling CPU's ring, safe from any context including interrupt handlers */
+extern void trace_record(uint32_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+
+/* Handles the TRACE_* commands, returns 0 or -1 if cmd is invalid */
+extern int32_t trace_ctl(int32_t cmd);
+
+/* Moves up to count unread events out of the rings (one CPU at a time, oldest first), returns how many */
+extern int32_t trace_read(trace_event_t* events, int32_t count);
+
+#endif /* _TRACE_H */
+
+#endif /* ASM */
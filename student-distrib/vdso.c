@@ -0,0 +1,36 @@
+/* vdso.c - Read-only kernel data page mapped into every user program
+ * vim:ts=4 noexpandtab
+ */
+
+#include "vdso.h"
+#include "pit.h"
+
+/* Mapped read-only at VDSO_ADDR by paging_init() */
+vdso_page_t vdso_page __attribute__((aligned(VDSO_SIZE)));
+
+/* vdso_init
+ * 
+ * Fills in the fields that don't depend on the clock, the rest start out at 0
+ * Inputs: None
+ * Outputs: None
+ */
+void vdso_init() {
+    vdso_page.data.tick_ms = PIT_TICK_MS;
+    vdso_page.data.pid = -1;
+    vdso_page.data.terminal = -1;
+}
+
+/* vdso_set_current
+ * 
+ * Called right before switching to a process so the page shows the pid and terminal
+ * of whoever is reading it. Every process shares the one page, which works because
+ * processes only run on the BSP (see smp.h), one at a time. If the APs ever run
+ * processes these two fields have to move to a page per CPU.
+ * Inputs: pid - process being switched to
+ *         terminal - terminal the process belongs to
+ * Outputs: None
+ */
+void vdso_set_current(int32_t pid, int32_t terminal) {
+    vdso_page.data.pid = pid;
+    vdso_page.data.terminal = terminal;
+}
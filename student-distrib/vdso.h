@@ -0,0 +1,63 @@
+/* vdso.h - Read-only kernel data page mapped into every user program
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _VDSO_H
+#define _VDSO_H
+
+#include "types.h"
+#include "lib.h"
+
+/* One 4KB page (not PAGE_SIZE, paging.h includes this file indirectly through pid.h and syscall.h) */
+#define VDSO_SIZE       4096
+
+#ifndef ASM
+
+/* Layout of the page as seen by user programs (mirrored in syscalls/ece391support.h).
+ * seq is odd while the kernel is in the middle of an update, readers retry until they
+ * see the same even value before and after reading. Single word fields are always
+ * written in one store so they can be read without checking seq. */
+typedef struct vdso_data {
+    volatile uint32_t seq;      /* Update sequence count */
+    uint32_t tsc_khz;           /* TSC frequency in kHz, 0 if the clock can't be read from user space */
+    uint64_t tsc_base;          /* TSC value at time 0 */
+    uint32_t ns_mult;           /* ns = ((tsc - tsc_base) * ns_mult) >> ns_shift */
+    uint32_t ns_shift;
+    uint32_t us_mult;           /* us = ((tsc - tsc_base) * us_mult) >> us_shift */
+    uint32_t us_shift;
+    volatile uint32_t ticks;    /* PIT ticks since boot (updated by pit_handler) */
+    uint32_t tick_ms;           /* Length of one PIT tick in ms */
+    volatile int32_t pid;       /* pid of the process reading the page (BSP only, see vdso_set_current) */
+    volatile int32_t terminal;  /* Terminal the reading process runs in (BSP only) */
+    volatile uint32_t rtc_ticks[TERMINAL_COUNT];   /* Virtual RTC interrupts delivered to each terminal (updated by rtc_handler) */
+} vdso_data_t;
+
+/* Pad to a full page so no other kernel data becomes user readable */
+typedef union vdso_page {
+    vdso_data_t data;
+    uint8_t pad[VDSO_SIZE];
+} vdso_page_t;
+
+extern vdso_page_t vdso_page;
+
+/* Fills in the fields that don't depend on the clock */
+extern void vdso_init();
+
+/* Records which process is about to run in user space */
+extern void vdso_set_current(int32_t pid, int32_t terminal);
+
+/* Marks the start of an update (interrupts should be off) */
+static inline void vdso_begin_update(void) {
+    vdso_page.data.seq++;
+    asm volatile ("" : : : "memory");
+}
+
+/* Marks the end of an update */
+static inline void vdso_end_update(void) {
+    asm volatile ("" : : : "memory");
+    vdso_page.data.seq++;
+}
+
+#endif /* _VDSO_H */
+
+#endif /* ASM */
@@ -16,6 +16,10 @@
 #define KERNEL_TSS  0x0030
 #define KERNEL_LDT  0x0038
 
+/* TSS entries for the application processors follow the LDT (0x40, 0x48, ...) */
+#define AP_TSS_BASE 0x0040
+#define NUM_AP_TSS  3
+
 /* Size of the task state segment (TSS) */
 #define TSS_SIZE    104
 
@@ -124,6 +128,8 @@ extern uint32_t tss_size;
 extern seg_desc_t tss_desc_ptr;
 extern tss_t tss;
 
+extern seg_desc_t ap_tss_desc_ptr[NUM_AP_TSS];
+
 /* Sets runtime-settable parameters in the GDT entry for the LDT */
 #define SET_LDT_PARAMS(str, addr, lim)                          \
 do {                                                            \
@@ -9,6 +9,11 @@
 #include "lib.h"
 #include "terminal.h"
 #include "scheduler.h"
+#include "timer.h"
+#include "vdso.h"
+#include "apic.h"
+#include "latency.h"
+#include "trace.h"
 
 
 int rtc_test_flag = 0;
@@ -47,6 +52,7 @@ void rtc_handler() {
 
     /* Iterate through each terminal and update RTC data if a process has opened RTC in that terminal */
     int i;
+    uint32_t fired = 0;
     for(i = 0;i < TERMINAL_COUNT;++i){
         if(terminal_rtc_data[i].rtc_rate != -1){
             terminal_rtc_data[i].rtc_counter++;
@@ -54,10 +60,16 @@ void rtc_handler() {
             if(terminal_rtc_data[i].rtc_counter == terminal_rtc_data[i].rtc_rate){
                 terminal_rtc_data[i].rtc_counter = 0;
                 terminal_rtc_data[i].rtc_read_flag++;//increment the read flag counter for a terminal that should fire an RTC tick
+                vdso_page.data.rtc_ticks[i]++;
+                latency_wake(i, LAT_RTC);
+                fired |= (1 << i);
             }
         }
     }
 
+    /* Only ticks a terminal sees are traced, the 512 Hz master rate would flood the ring */
+    if (fired) trace_record(TRACE_RTC, fired, 0, 0);
+
     /* Throw away contents of register C of RTC */
     outb(RTC_REGISTER_C, RTC_INDEX_PORT);
     inb(RTC_DATA_PORT);	
@@ -66,63 +78,114 @@ void rtc_handler() {
     send_eoi(RTC_IRQ);
 }
 
+/* Scancodes from keyboard_handler to keyboard_bottom_half, both only run on the BSP */
+static uint8_t kbd_ring[KBD_RING_SIZE];
+static volatile uint32_t kbd_head;          /* Scancodes ever queued */
+static volatile uint32_t kbd_tail;          /* Scancodes ever decoded */
+
+/* Set while keyboard_bottom_half runs, the timer ticks don't call schedule() then */
+static volatile int32_t kbd_draining = 0;
+
+static void keyboard_key(uint8_t data);
+
 /* void  keyboard_handler
  * Inputs: void
  * Return Value: void
- * Function: Interrupt Handler for keyboard, writes to keyboard buf and to the screen as well.
- *           This also handles different states for keyboard such as CAPSLOCK and SHIFT
+ * Function: Interrupt Handler for keyboard, the top half. Only reads the scancode and
+ *           queues it for keyboard_bottom_half, which the link runs right after this
+ *           with interrupts back on. Scancodes past a full ring are dropped
  * 
  *  
  */
 void keyboard_handler() {
-    uint32_t flags;
-    cli_and_save(flags);
-
-    key_map output_key = {0};
-    uint8_t c;
-    uint8_t scancode;
-
-    /* Switch to shown terminal screen */
-    switch_screen(terminal_active, terminal_shown, 0);
-
     /* get our value from the port*/
     uint32_t data = inb(KB_DATA_PORT);
-    
-   
+    trace_record(TRACE_KEYBOARD, data, terminal_shown, 0);
 
-    /* get the proper scancode whether it is released or pressed*/
-    scancode = (uint8_t)(data & (~(1 << 7)));
-    
     /* check if the port is an ACK bit */
-    if (data == KB_ACK) {
-        kboard_ack = 1;
-        switch_screen(terminal_shown, terminal_active, 0);
-        send_eoi(KEYBOARD_IRQ);
-        restore_flags(flags);
-        return;
+    if (data == KB_ACK) kboard_ack = 1;
+    else keyboard_queue(data);
+
+    /* Send EOI signal at end of handler */
+    send_eoi(KEYBOARD_IRQ);
+}
+
+/* int32_t keyboard_queue
+ * Inputs: data - scancode the keyboard sent
+ * Return Value: 0 on success, -1 if the ring is full (the scancode is dropped)
+ * Function: Queues a scancode for keyboard_bottom_half, interrupts must be off
+ */
+int32_t keyboard_queue(uint8_t data) {
+    uint32_t head = kbd_head;
+
+    if (head - kbd_tail == KBD_RING_SIZE) return -1;
+    kbd_ring[head & KBD_RING_MASK] = data;
+    kbd_head = head + 1;
+    return 0;
+}
+
+/* void keyboard_bottom_half
+ * Inputs: void
+ * Return Value: void
+ * Function: Decodes the queued scancodes with interrupts on, called with them off by the
+ *           keyboard link after keyboard_handler and returns with them off. A keyboard
+ *           interrupt that comes in meanwhile only queues its scancode and leaves it to
+ *           the bottom half that is already running. It runs on the interrupted process's
+ *           kernel stack, so the timer ticks must not switch away until it is done or the
+ *           queued scancodes would wait until that process runs again (see scheduler_tick)
+ */
+void keyboard_bottom_half() {
+    uint8_t data;
+
+    if (kbd_draining) return;
+    kbd_draining = 1;
+
+    while (kbd_tail != kbd_head) {
+        data = kbd_ring[kbd_tail & KBD_RING_MASK];
+        kbd_tail++;
+        sti();
+        keyboard_key(data);
+        cli();
     }
+
+    kbd_draining = 0;
+}
+
+/* static void keyboard_key
+ * Inputs: data - scancode the keyboard sent
+ * Return Value: void
+ * Function: Updates the state keys (CAPSLOCK, SHIFT, ...), handles the keys the kernel
+ *           acts on itself (scrollback, Ctrl+L, Alt+F1-F3) and queues the rest for the
+ *           shown terminal's reader (see terminal_key_push)
+ */
+static void keyboard_key(uint8_t data) {
+    key_map output_key = {0};
+    uint8_t c;
+
+    /* get the proper scancode whether it is released or pressed*/
+    uint8_t scancode = (uint8_t)(data & (~(1 << 7)));
+
     /* Update our state keys */
     update_state_keys(scancode, data);
+
+    /* Shift+PageUp/PageDown browse the scrollback, any other key press goes back to the console */
+    if (!(data & (1 << 7))) {
+        if ((key_state[L_SHIFT_IDX].state || key_state[R_SHIFT_IDX].state) &&
+            (scancode == PAGE_UP || scancode == PAGE_DOWN)) {
+            console_view_scroll(terminal_shown, scancode == PAGE_UP ? SCROLLBACK_STEP : -SCROLLBACK_STEP);
+            return;
+        }
+        if (scancode != key_state[L_SHIFT_IDX].scancode && scancode != key_state[R_SHIFT_IDX].scancode)
+            console_view_reset(terminal_shown);
+    }
    
     /* Check if our scancode match a letter or number key (any printable key) */
     check_keys(scancode, data, &output_key);
     
     /* check for CTRL+L*/
-    if ((key_state[CTRL_IDX].state) && (output_key.unshifted == 'l') && (output_key.state)) {
-        clear();
-        switch_screen(terminal_shown, terminal_active, 0);
-        restore_flags(flags);
-        send_eoi(KEYBOARD_IRQ);
-        return;
-    }
-
-    /* Check for up or down (viewing saved command history) */
-    if (key_state[UP_IDX].state || key_state[DOWN_IDX].state) {
-        if (key_state[UP_IDX].state) type_command(1);
-        else if (key_state[DOWN_IDX].state) type_command(0);
-        switch_screen(terminal_shown, terminal_active, 0);
-        restore_flags(flags);
-        send_eoi(KEYBOARD_IRQ);
+    if ((key_state[CTRL_IDX].state) && (output_key.unshifted == 'l') && (output_key.state) &&
+        !(terminal_ctx[terminal_shown].mode & TERM_RAW)) {
+        console_clear(terminal_shown);
         return;
     }
 
@@ -139,44 +202,59 @@ void keyboard_handler() {
         }  
     } 
 
-    /* check if we found a printable character*/
-    if (!output_key.scancode || !output_key.state) {
-        switch_screen(terminal_shown, terminal_active, 0);
-        restore_flags(flags);
-        send_eoi(KEYBOARD_IRQ);
-        return;
-    }
-   
-    /* get the proper character by checking the state of our keyboard */
-    c = check_states(&output_key);
-
-    /* check if it is a backspace because we do not add that to buffer or print it */
-    if (output_key.scancode == BACKSPACE) backspace_pressed();
-    
-    
-    /* BEFORE MODIFYING OUR BUFFER WE CHECK IF WE HAVE OVERFLOW */
-    /* if our buffer is full i.e. we are at index 126 (i = 127 is our \n) we dont do anything*/
-    if(check_buffer_overflow(&output_key)) {
-        switch_screen(terminal_shown, terminal_active, 0);
-        restore_flags(flags);
-        send_eoi(KEYBOARD_IRQ);
-        return;
+    /* Queue the key for the terminal's reader, it does the echo and line editing */
+    if (!(data & (1 << 7))) {
+        c = 0;
+        if (scancode == key_state[UP_IDX].scancode) c = KEY_UP;
+        else if (scancode == key_state[DOWN_IDX].scancode) c = KEY_DOWN;
+        else if (output_key.scancode && output_key.state) {
+            /* get the proper character by checking the state of our keyboard */
+            c = check_states(&output_key);
+            if (key_state[CTRL_IDX].state && output_key.unshifted >= 'a' && output_key.unshifted <= 'z') c &= 0x1F;
+        }
+        if (c) terminal_key_push(terminal_shown, c);
     }
-    
-    /* add our character to the buffer and output to screen*/
-    add_to_buffer(c, &output_key);
-
-    /* Switch back to active terminal screen */
-    switch_screen(terminal_shown, terminal_active, 0);
 
+}
 
-    /* Send EOI signal at end of handler */
-    restore_flags(flags);
-    send_eoi(KEYBOARD_IRQ);
+/* void scheduler_tick
+ * Inputs: void
+ * Return Value: void
+ * Function: Work done on every scheduler tick no matter which timer delivered it. Advances
+ *           the timer wheel (waking up sleeping processes), publishes the tick in the vdso
+ *           page, shows what was written to the consoles since the last tick and then lets
+ *           the scheduler pick the next terminal to run. The EOI must
+ *           already be sent since schedule() may not come back here for a while.
+ *           A tick that lands in the keyboard bottom half doesn't switch, the process it
+ *           interrupted keeps running until the next tick.
+ */
+static void scheduler_tick(){
+    timer_tick();
+    vdso_page.data.ticks = timer_ticks;
+    console_flush_all();
+    if (!kbd_draining) schedule();
 }
 
+/* void pit_handler
+ * Inputs: void
+ * Return Value: void
+ * Function: Interrupt handler for the PIT, only used when there is no local APIC timer
+ */
 void pit_handler(){
     //printf("PIT handler entered!\n");
     send_eoi(PIT_IRQ);
-    schedule();
+    trace_record(TRACE_TICK, timer_ticks, TRACE_TICK_PIT, 0);
+    scheduler_tick();
+}
+
+/* void lapic_timer_handler
+ * Inputs: void
+ * Return Value: void
+ * Function: Interrupt handler for the local APIC timer, re-arms the next tick first
+ */
+void lapic_timer_handler(){
+    lapic_eoi();
+    lapic_timer_arm();
+    trace_record(TRACE_TICK, timer_ticks, TRACE_TICK_LAPIC, 0);
+    scheduler_tick();
 }
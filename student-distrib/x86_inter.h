@@ -40,9 +40,19 @@ extern void rtc_handler();
 /* RTC link function to be called from x86_interrupts.S */
 extern void rtc_handler_link();
 
+/* Scancodes the keyboard top half queued for the bottom half (power of 2) */
+#define KBD_RING_SIZE   64
+#define KBD_RING_MASK   (KBD_RING_SIZE - 1)
+
 /* Keyboard handler code */
 extern void keyboard_handler();
 
+/* Queues a scancode for the keyboard bottom half, -1 if the ring is full */
+extern int32_t keyboard_queue(uint8_t data);
+
+/* Keyboard bottom half, decodes what keyboard_handler queued with interrupts on */
+extern void keyboard_bottom_half();
+
 /* Keyboard link function to be called from x86_interrupts.S */
 extern void keyboard_handler_link();
 
@@ -52,6 +62,15 @@ extern void pit_handler();
 /* PIT link function to be called from x86_interrupts.S */
 extern void pit_handler_link();
 
+/* Local APIC timer handler (scheduler tick when the APIC is available) */
+extern void lapic_timer_handler();
+
+/* Link to the assembly for the local APIC timer handler */
+extern void lapic_timer_handler_link();
+
+/* Local APIC spurious interrupt handler (just irets) */
+extern void lapic_spurious_link();
+
 /* Sys call link function to be called form x86_interrupts.S */
 extern void sys_call_handler_link();
 
@@ -7,7 +7,7 @@
 
 int main ()
 {
-    uint32_t i, cnt, max = 0;
+    uint32_t i, cnt, max = 0, start_us, us;
     uint8_t buf[BUFSIZE];
 
     ece391_fdputs(1, (uint8_t*)"Enter the Test Number: (0): 100, (1): 10000, (2): 100000\n");
@@ -34,11 +34,25 @@ int main ()
         }
     }
 
+    start_us = ece391_clock_us();
     for (i = 0; i < max; i++) {
         ece391_itoa(i+1, buf, 10);
         ece391_fdputs(1, buf);
         ece391_fdputs(1, (uint8_t*)"\n");
     }
+    us = ece391_clock_us() - start_us;
+
+    /* Throughput, so console changes can be compared with "counter" then 2 */
+    ece391_fdputs(1, (uint8_t*)"printed ");
+    ece391_itoa(max, buf, 10);
+    ece391_fdputs(1, buf);
+    ece391_fdputs(1, (uint8_t*)" lines in ");
+    ece391_itoa(us / 1000, buf, 10);
+    ece391_fdputs(1, buf);
+    ece391_fdputs(1, (uint8_t*)" ms, ");
+    ece391_itoa(us >= 1000 ? max * 1000 / (us / 1000) : max * 1000, buf, 10);
+    ece391_fdputs(1, buf);
+    ece391_fdputs(1, (uint8_t*)" lines/s\n");
 
     return 0;
 }
@@ -0,0 +1,112 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * Shows how often each interrupt and exception handler has run since boot
+ * and how much of the CPU it has taken. Timer handlers are only charged up
+ * to the point where they switch to another process.
+ */
+
+#define NUMSIZE         16
+#define MAX_VECTORS     256
+#define NUM_EXCEPTIONS  20
+
+static ece391_irq_stat_t stats[MAX_VECTORS];
+
+static const char* exception_names[NUM_EXCEPTIONS] = {
+    "divide error", "debug", "nmi", "breakpoint", "overflow",
+    "bound range", "invalid opcode", "no fpu", "double fault",
+    "fpu segment overrun", "invalid tss", "segment not present",
+    "stack fault", "general protection", "page fault", "reserved",
+    "fpu error", "alignment check", "machine check", "simd error"
+};
+
+static const char* vector_name (uint32_t vector)
+{
+    if (vector < NUM_EXCEPTIONS)
+        return exception_names[vector];
+    switch (vector) {
+    case 0x20: return "pit";
+    case 0x21: return "keyboard";
+    case 0x28: return "rtc";
+    case 0x40: return "lapic timer";
+    default:   return "?";
+    }
+}
+
+static void put_str (const char* s)
+{
+    ece391_fdputs (1, (const uint8_t*)s);
+}
+
+/* Prints s and pads it with spaces to width columns */
+static void put_str_width (const char* s, uint32_t width)
+{
+    uint32_t len;
+
+    put_str (s);
+    for (len = ece391_strlen ((const uint8_t*)s); len < width; len++)
+        put_str (" ");
+}
+
+/* Prints a byte as two hex digits */
+static void put_hex2 (uint32_t value)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    uint8_t buf[3];
+
+    buf[0] = digits[(value >> 4) & 0xF];
+    buf[1] = digits[value & 0xF];
+    buf[2] = '\0';
+    ece391_fdputs (1, buf);
+}
+
+/* Prints value right aligned in width columns */
+static void put_num_width (uint32_t value, uint32_t width)
+{
+    uint8_t buf[NUMSIZE];
+    uint32_t len;
+
+    ece391_itoa (value, buf, 10);
+    for (len = ece391_strlen (buf); len < width; len++)
+        put_str (" ");
+    ece391_fdputs (1, buf);
+}
+
+int main ()
+{
+    ece391_timespec_t now;
+    uint32_t uptime_ms, tenths;
+    int32_t n, i;
+
+    n = ece391_kstat (KSTAT_IRQ, stats, sizeof (stats));
+    if (n < 0 || -1 == ece391_clock_gettime (&now)) {
+        put_str ("irqstat: kstat failed\n");
+        return 2;
+    }
+    uptime_ms = now.sec * 1000 + now.nsec / 1000000;
+    if (0 == uptime_ms)
+        uptime_ms = 1;
+
+    put_str ("vector  handler                    count     time ms  cycles/call   %cpu\n");
+    for (i = 0; i < n; i++) {
+        put_str ("  0x");
+        put_hex2 (stats[i].vector);
+        put_str ("  ");
+        put_str_width (vector_name (stats[i].vector), 20);
+        put_num_width (stats[i].count, 12);
+        put_num_width (stats[i].time_us / 1000, 12);
+        put_num_width (stats[i].avg_cycles, 13);
+
+        /* time_us / (uptime_ms * 1000) as a percentage with one decimal */
+        tenths = stats[i].time_us / uptime_ms;
+        put_num_width (tenths / 10, 5);
+        put_str (".");
+        put_num_width (tenths % 10, 1);
+        put_str ("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * Prints the kernel's wakeup latency histograms: how long each terminal's
+ * process took to run again after Enter, an RTC tick or the end of a sleep.
+ * Only terminals and sources that have seen a wakeup are shown.
+ */
+
+#define BUFSIZE         16
+#define TERMINALS       3
+#define BAR_WIDTH       40
+
+static const char* sources[LAT_SOURCES] = {"keyboard", "rtc", "sleep"};
+
+static void put_num (uint32_t value)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* Prints value right aligned in width columns */
+static void put_num_width (uint32_t value, uint32_t width)
+{
+    uint8_t buf[BUFSIZE];
+    uint32_t len;
+
+    ece391_itoa (value, buf, 10);
+    for (len = ece391_strlen (buf); len < width; len++)
+        ece391_fdputs (1, (uint8_t*)" ");
+    ece391_fdputs (1, buf);
+}
+
+static void print_hist (const ece391_lat_hist_t* h)
+{
+    uint32_t i, j, peak = 0, bar;
+
+    for (i = 0; i < LAT_BUCKETS; i++)
+        if (h->buckets[i] > peak)
+            peak = h->buckets[i];
+
+    for (i = 0; i < LAT_BUCKETS; i++) {
+        if (0 == h->buckets[i])
+            continue;
+        put_num_width (i == 0 ? 0 : 1U << i, 10);
+        ece391_fdputs (1, (uint8_t*)" us | ");
+        bar = h->buckets[i] * BAR_WIDTH / peak;
+        for (j = 0; j < (bar == 0 ? 1 : bar); j++)
+            ece391_fdputs (1, (uint8_t*)"#");
+        ece391_fdputs (1, (uint8_t*)" ");
+        put_num (h->buckets[i]);
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+}
+
+int main ()
+{
+    ece391_lat_hist_t hists[TERMINALS * LAT_SOURCES];
+    const ece391_lat_hist_t* h;
+    int32_t n, i, shown = 0;
+
+    n = ece391_kstat (KSTAT_LATENCY, hists, sizeof (hists));
+    if (n < 0) {
+        ece391_fdputs (1, (uint8_t*)"latency: kstat failed\n");
+        return 2;
+    }
+
+    for (i = 0; i < n; i++) {
+        h = &hists[i];
+        if (0 == h->count)
+            continue;
+        shown++;
+
+        ece391_fdputs (1, (uint8_t*)"terminal ");
+        put_num (i / LAT_SOURCES);
+        ece391_fdputs (1, (uint8_t*)", ");
+        ece391_fdputs (1, (uint8_t*)sources[i % LAT_SOURCES]);
+        ece391_fdputs (1, (uint8_t*)": ");
+        put_num (h->count);
+        ece391_fdputs (1, (uint8_t*)" wakeups, avg ");
+        put_num (h->total_us / h->count);
+        ece391_fdputs (1, (uint8_t*)" us, max ");
+        put_num (h->max_us);
+        ece391_fdputs (1, (uint8_t*)" us\n");
+        print_hist (h);
+    }
+
+    if (0 == shown)
+        ece391_fdputs (1, (uint8_t*)"latency: no wakeups recorded yet\n");
+
+    return 0;
+}
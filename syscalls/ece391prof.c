@@ -0,0 +1,94 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * Profiles a command, e.g. "prof counter". Samples are taken on every timer
+ * and RTC interrupt while the command runs. A summary is printed here and
+ * the samples are dumped to the serial port for symbolize.py to resolve.
+ */
+
+#define BUFSIZE         128
+#define NUMSIZE         16
+#define MAX_SAMPLES     16384
+#define SOURCES         3
+
+static ece391_profile_sample_t samples[MAX_SAMPLES];
+
+static const char* source_names[SOURCES] = {"pit", "lapic", "rtc"};
+
+static void put_str (const char* s)
+{
+    ece391_fdputs (1, (const uint8_t*)s);
+}
+
+static void put_num (uint32_t value)
+{
+    uint8_t buf[NUMSIZE];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* Prints "<count> (<percent>%)" */
+static void put_share (uint32_t count, uint32_t total)
+{
+    put_num (count);
+    put_str (" (");
+    put_num (total ? count * 100 / total : 0);
+    put_str ("%)");
+}
+
+int main ()
+{
+    uint8_t cmd[BUFSIZE];
+    uint32_t user = 0, kernel = 0, by_source[SOURCES] = {0, 0, 0};
+    int32_t n, i, ret;
+
+    if (0 != ece391_getargs (cmd, BUFSIZE) || '\0' == cmd[0]) {
+        put_str ("usage: prof <command> [args]\n");
+        return 3;
+    }
+
+    ece391_profile (PROFILE_START);
+    ret = ece391_execute (cmd);
+    ece391_profile (PROFILE_STOP);
+
+    if (-1 == ret) {
+        put_str ("prof: no such command\n");
+        return 2;
+    }
+
+    n = ece391_kstat (KSTAT_PROFILE, samples, sizeof (samples));
+    for (i = 0; i < n; i++) {
+        if (samples[i].cpl == 3)
+            user++;
+        else
+            kernel++;
+        if (samples[i].source < SOURCES)
+            by_source[samples[i].source]++;
+    }
+
+    put_str ("prof: ");
+    put_num (n);
+    put_str (" samples, user ");
+    put_share (user, n);
+    put_str (", kernel ");
+    put_share (kernel, n);
+    put_str ("\n");
+    for (i = 0; i < SOURCES; i++) {
+        if (0 == by_source[i])
+            continue;
+        put_str ("  ");
+        put_str (source_names[i]);
+        put_str (": ");
+        put_num (by_source[i]);
+        put_str ("\n");
+    }
+
+    put_str ("prof: writing samples to the serial port\n");
+    ece391_profile (PROFILE_DUMP);
+
+    return 0;
+}
@@ -2,13 +2,122 @@
 
 #include "ece391support.h"
 #include "ece391syscall.h"
+#include "ece391sysname.h"
 
 #define BUFSIZE 1024
+#define TIME_PREFIX "time "
+#define TIME_PREFIX_LEN 5
+#define STRACE_PREFIX "strace "
+#define STRACE_PREFIX_LEN 7
+#define STRACE_RECS 32
+
+static ece391_strace_rec_t recs[STRACE_RECS];
+
+/* Prints "<label> <sec>.<msec>s" */
+static void print_time (const char* label, uint32_t sec, uint32_t usec)
+{
+    uint8_t num[16];
+    uint32_t ms = usec / 1000;
+
+    ece391_fdputs (1, (uint8_t*)label);
+    ece391_itoa (sec, num, 10);
+    ece391_fdputs (1, num);
+    ece391_fdputs (1, (uint8_t*)".");
+    if (ms < 100) ece391_fdputs (1, (uint8_t*)"0");
+    if (ms < 10) ece391_fdputs (1, (uint8_t*)"0");
+    ece391_itoa (ms, num, 10);
+    ece391_fdputs (1, num);
+    ece391_fdputs (1, (uint8_t*)"s\n");
+}
+
+/* Difference of two timevals, a must not be earlier than b */
+static void time_sub (ece391_timeval_t* a, ece391_timeval_t* b)
+{
+    if (a->usec < b->usec) {
+        a->usec += 1000000;
+        a->sec--;
+    }
+    a->usec -= b->usec;
+    a->sec -= b->sec;
+}
+
+/* Prints small values in decimal and anything that looks like a pointer in hex */
+static void print_arg (int32_t value)
+{
+    uint8_t num[16];
+
+    if (value < 0) {
+        ece391_fdputs (1, (uint8_t*)"-");
+        ece391_itoa (-value, num, 10);
+    } else if (value < 0x10000) {
+        ece391_itoa (value, num, 10);
+    } else {
+        ece391_fdputs (1, (uint8_t*)"0x");
+        ece391_itoa (value, num, 16);
+    }
+    ece391_fdputs (1, num);
+}
+
+/* Prints "[pid N] name(args) = ret <usec>" */
+static void print_strace (const ece391_strace_rec_t* rec)
+{
+    uint8_t num[16];
+    uint32_t i, nargs;
+
+    ece391_fdputs (1, (uint8_t*)"[pid ");
+    ece391_itoa (rec->pid, num, 10);
+    ece391_fdputs (1, num);
+    ece391_fdputs (1, (uint8_t*)"] ");
+    ece391_fdputs (1, (uint8_t*)(rec->num < NUM_SYSCALLS ? syscall_names[rec->num] : syscall_names[0]));
+    ece391_fdputs (1, (uint8_t*)"(");
+    nargs = rec->num < NUM_SYSCALLS ? syscall_args[rec->num] : 3;
+    for (i = 0; i < nargs; i++) {
+        if (i > 0)
+            ece391_fdputs (1, (uint8_t*)", ");
+        if (0 == i && '\0' != rec->str[0]) {
+            ece391_fdputs (1, (uint8_t*)"\"");
+            ece391_fdputs (1, (uint8_t*)rec->str);
+            ece391_fdputs (1, (uint8_t*)"\"");
+        } else {
+            print_arg (rec->args[i]);
+        }
+    }
+    ece391_fdputs (1, (uint8_t*)") = ");
+    print_arg (rec->ret);
+    ece391_fdputs (1, (uint8_t*)" <");
+    ece391_itoa (rec->usec, num, 10);
+    ece391_fdputs (1, num);
+    ece391_fdputs (1, (uint8_t*)"us>\n");
+}
+
+/* Empties the kernel's strace ring, printing what's in it if show is set */
+static void drain_strace (int32_t show)
+{
+    int32_t n, i;
+    uint32_t next = 0, first = 1;
+    uint8_t num[16];
+
+    while ((n = ece391_kstat (KSTAT_STRACE, recs, sizeof (recs))) > 0) {
+        for (i = 0; show && i < n; i++) {
+            if (!first && recs[i].seq != next) {
+                ece391_fdputs (1, (uint8_t*)"strace: ");
+                ece391_itoa (recs[i].seq - next, num, 10);
+                ece391_fdputs (1, num);
+                ece391_fdputs (1, (uint8_t*)" calls lost\n");
+            }
+            print_strace (&recs[i]);
+            next = recs[i].seq + 1;
+            first = 0;
+        }
+    }
+}
 
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, timed;
     uint8_t buf[BUFSIZE];
+    ece391_rusage_t before, after;
+    uint32_t start_us, real_us;
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
     while (1) {
@@ -24,7 +133,29 @@ int main ()
 	    return 0;
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	/* "time <command>" runs command and reports how long it took */
+	timed = (0 == ece391_strncmp (buf, (uint8_t*)TIME_PREFIX, TIME_PREFIX_LEN));
+	if (timed) {
+	    ece391_getrusage (RUSAGE_CHILDREN, &before);
+	    start_us = ece391_clock_us ();
+	    rval = ece391_execute (buf + TIME_PREFIX_LEN);
+	    real_us = ece391_clock_us () - start_us;
+	    ece391_getrusage (RUSAGE_CHILDREN, &after);
+	    time_sub (&after.utime, &before.utime);
+	    time_sub (&after.stime, &before.stime);
+	    print_time ("real ", real_us / 1000000, real_us % 1000000);
+	    print_time ("user ", after.utime.sec, after.utime.usec);
+	    print_time ("sys  ", after.stime.sec, after.stime.usec);
+	} else if (0 == ece391_strncmp (buf, (uint8_t*)STRACE_PREFIX, STRACE_PREFIX_LEN)) {
+	    /* "strace <command>" runs command and then lists the syscalls it made */
+	    drain_strace (0);
+	    ece391_strace (STRACE_CHILDREN_PID, 1);
+	    rval = ece391_execute (buf + STRACE_PREFIX_LEN);
+	    ece391_strace (STRACE_CHILDREN_PID, 0);
+	    drain_strace (1);
+	} else {
+	    rval = ece391_execute (buf);
+	}
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
@@ -0,0 +1,63 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * Compute-bound throughput benchmark. Start one copy in each terminal at
+ * the same time (e.g. "spin 10") and add up the per-second rates to get the
+ * machine's total throughput. Every process runs on the boot CPU, so the
+ * total does not change with -smp; it shows how evenly the scheduler
+ * shares that CPU between terminals.
+ */
+
+#define BUFSIZE         32
+#define DEFAULT_SECS    5
+#define MAX_SECS        60
+#define CHUNK           1000    /* Iterations per chunk, so chunks/s = kiter/s */
+
+/* Keeps the compiler from throwing the loop away */
+static volatile uint32_t sink;
+
+int main ()
+{
+    const ece391_vdso_t* vdso = ECE391_VDSO;
+    uint8_t buf[BUFSIZE];
+    uint32_t secs = 0, i, sec, start, next;
+    uint32_t x = 1, chunks, total = 0;
+
+    if (0 == ece391_getargs (buf, BUFSIZE)) {
+        for (i = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+            secs = secs * 10 + (buf[i] - '0');
+    }
+    if (0 == secs || secs > MAX_SECS)
+        secs = DEFAULT_SECS;
+
+    start = vdso->ticks;
+    for (sec = 0; sec < secs; sec++) {
+        next = start + (sec + 1) * (1000 / vdso->tick_ms);
+        chunks = 0;
+        while ((int32_t)(vdso->ticks - next) < 0) {
+            for (i = 0; i < CHUNK; i++)
+                x = x * 1103515245 + 12345;
+            sink = x;
+            chunks++;
+        }
+        total += chunks;
+
+        ece391_fdputs (1, (uint8_t*)"spin (terminal ");
+        ece391_itoa (vdso->terminal, buf, 10);
+        ece391_fdputs (1, buf);
+        ece391_fdputs (1, (uint8_t*)"): ");
+        ece391_itoa (chunks, buf, 10);
+        ece391_fdputs (1, buf);
+        ece391_fdputs (1, (uint8_t*)" kiter/s\n");
+    }
+
+    ece391_fdputs (1, (uint8_t*)"spin average: ");
+    ece391_itoa (total / secs, buf, 10);
+    ece391_fdputs (1, buf);
+    ece391_fdputs (1, (uint8_t*)" kiter/s\n");
+
+    return 0;
+}
@@ -102,3 +102,43 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+
+/* (a * mul) >> shift without a 96-bit intermediate (and without libgcc) */
+static uint64_t vdso_scale(uint64_t a, uint32_t mul, uint32_t shift)
+{
+    uint64_t ret = ((uint64_t)(uint32_t)a * mul) >> shift;
+
+    if ((a >> 32) != 0)
+        ret += ((uint64_t)(uint32_t)(a >> 32) * mul) << (32 - shift);
+    return ret;
+}
+
+/* Reads the TSC and scales it to ns or us with the multipliers in the vdso page */
+static uint64_t vdso_clock(int32_t want_us)
+{
+    const ece391_vdso_t* vdso = ECE391_VDSO;
+    uint32_t seq, mul, shift;
+    uint64_t base, tsc;
+
+    do {
+        seq = vdso->seq;
+        base = vdso->tsc_base;
+        mul = want_us ? vdso->us_mult : vdso->ns_mult;
+        shift = want_us ? vdso->us_shift : vdso->ns_shift;
+        __asm__ volatile ("rdtsc" : "=A"(tsc));
+    } while ((seq & 1) || seq != vdso->seq);
+
+    if (vdso->tsc_khz == 0)
+        return 0;
+    return vdso_scale(tsc - base, mul, shift);
+}
+
+uint64_t ece391_clock_ns(void)
+{
+    return vdso_clock(0);
+}
+
+uint32_t ece391_clock_us(void)
+{
+    return (uint32_t)vdso_clock(1);
+}
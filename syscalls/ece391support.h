@@ -9,5 +9,34 @@ extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
 
+/* Read-only kernel data page, same layout as vdso_data_t in the kernel's vdso.h.
+ * Single word fields can be read directly, the clock fields are read with
+ * ece391_clock_ns/us below. */
+#define ECE391_VDSO_ADDR    0x08801000
+
+typedef struct ece391_vdso {
+	volatile uint32_t seq;
+	uint32_t tsc_khz;
+	uint64_t tsc_base;
+	uint32_t ns_mult;
+	uint32_t ns_shift;
+	uint32_t us_mult;
+	uint32_t us_shift;
+	volatile uint32_t ticks;	/* 10 ms scheduler ticks since boot */
+	uint32_t tick_ms;
+	volatile int32_t pid;		/* pid of the calling program (every program runs on CPU 0) */
+	volatile int32_t terminal;	/* terminal the calling program runs in */
+	volatile uint32_t rtc_ticks[3];	/* RTC interrupts delivered to each terminal */
+} ece391_vdso_t;
+
+/* The page itself, readable by every program without calling vidmap */
+#define ECE391_VDSO	((const ece391_vdso_t*)ECE391_VDSO_ADDR)
+
+/* Monotonic clock read straight from the TSC through the vdso page (no
+ * system call). Returns 0 if the kernel found no usable TSC. The us version
+ * wraps every ~71 minutes, which is fine for measuring intervals. */
+extern uint64_t ece391_clock_ns(void);
+extern uint32_t ece391_clock_us(void);
+
 #endif /* ECE391SUPPORT_H */
 
@@ -24,6 +24,173 @@ extern int32_t ece391_sigreturn (void);
 extern void* ece391_malloc (int32_t size);
 extern void ece391_free (void* ptr);
 
+/* Adds inc to the niceness of pid (negative pid = calling process, inc = 0 just reads it).
+ * A negative inc only works on the calling process and its descendants.
+ * Returns 20 - niceness, not the niceness itself, so that the result is always 1 to 40
+ * (higher gets more CPU time) and -1 can mean a bad pid or a refused negative inc. */
+extern int32_t ece391_nice (int32_t pid, int32_t inc);
+
+/* Gives up the rest of the time slice. Always returns 0. */
+extern int32_t ece391_yield (void);
+/* Sleeps for at least ms milliseconds (10 ms resolution). Always returns 0. */
+extern int32_t ece391_sleep (uint32_t ms);
+
+/* Monotonic time since boot with TSC resolution (see ece391_clock_us in
+ * ece391support.h for a version that doesn't need a system call). */
+typedef struct ece391_timespec {
+	uint32_t sec;
+	uint32_t nsec;
+} ece391_timespec_t;
+extern int32_t ece391_clock_gettime (ece391_timespec_t* ts);
+
+/* CPU time used by the caller (RUSAGE_SELF) or by all of its children that
+ * have halted (RUSAGE_CHILDREN). */
+#define RUSAGE_SELF	0
+#define RUSAGE_CHILDREN	(-1)
+typedef struct ece391_timeval {
+	uint32_t sec;
+	uint32_t usec;
+} ece391_timeval_t;
+typedef struct ece391_rusage {
+	ece391_timeval_t utime;
+	ece391_timeval_t stime;
+} ece391_rusage_t;
+extern int32_t ece391_getrusage (int32_t who, ece391_rusage_t* ru);
+
+/* Kernel statistics. Fills buf with as many entries of the requested kind as
+ * fit in nbytes and returns how many were written. KSTAT_PROC gives one
+ * ece391_procstat_t per process, lowest pid first. */
+#define KSTAT_PROC	0
+#define PROC_RUNNING	0	/* runs whenever its terminal is scheduled */
+#define PROC_SLEEPING	1	/* in ece391_sleep */
+#define PROC_WAITING	2	/* waiting for a child to halt */
+typedef struct ece391_procstat {
+	int32_t pid;
+	int32_t parent_pid;	/* -1 for a base shell */
+	int32_t terminal;
+	int32_t state;
+	int32_t nice;
+	uint32_t utime_ms;
+	uint32_t stime_ms;
+	uint32_t mem_bytes;	/* program image + kernel stack + vidmap page */
+	uint32_t open_fds;
+	uint8_t name[33];
+} ece391_procstat_t;
+
+/* KSTAT_LATENCY gives one ece391_lat_hist_t per terminal and wakeup source,
+ * ordered [terminal][source]: the time from a wakeup to the woken process
+ * running again. Bucket i counts latencies of 2^i to 2^(i+1)-1 us. */
+#define KSTAT_LATENCY	1
+#define LAT_KEYBOARD	0	/* Enter while waiting in read on stdin */
+#define LAT_RTC		1	/* RTC tick while waiting in read on the rtc */
+#define LAT_SLEEP	2	/* end of ece391_sleep */
+#define LAT_SOURCES	3
+#define LAT_BUCKETS	32
+typedef struct ece391_lat_hist {
+	uint32_t count;
+	uint32_t total_us;
+	uint32_t max_us;
+	uint32_t buckets[LAT_BUCKETS];
+} ece391_lat_hist_t;
+
+/* KSTAT_TRACE moves unread kernel trace events out of the kernel's per-CPU
+ * rings (oldest first, one CPU after another). Each ring keeps the last
+ * 2048 events. */
+#define KSTAT_TRACE	2
+#define TRACE_SCHED	1	/* old terminal, new terminal, new pid */
+#define TRACE_SYSCALL	2	/* number, first two args */
+#define TRACE_EXECUTE	3	/* new pid, parent pid, terminal */
+#define TRACE_HALT	4	/* pid, pid returned to, status */
+#define TRACE_RTC	5	/* bitmask of terminals that got an RTC tick */
+#define TRACE_KEYBOARD	6	/* byte from the keyboard, shown terminal */
+#define TRACE_TICK	7	/* tick count, 0 = PIT or 1 = local APIC timer */
+typedef struct ece391_trace_event {
+	uint32_t sec;
+	uint32_t nsec;
+	uint16_t cpu;
+	uint16_t id;
+	uint32_t pid;
+	uint32_t args[3];
+} ece391_trace_event_t;
+
+/* KSTAT_PROFILE copies the samples of the current profiling run */
+#define KSTAT_PROFILE	3
+typedef struct ece391_profile_sample {
+	uint32_t eip;		/* where the timer or RTC interrupt came in */
+	uint16_t pid;
+	uint8_t cpl;		/* 0 = kernel, 3 = user */
+	uint8_t source;		/* 0 = PIT, 1 = local APIC timer, 2 = RTC */
+} ece391_profile_sample_t;
+
+/* KSTAT_IRQ gives one ece391_irq_stat_t for every interrupt or exception
+ * vector that has fired since boot, lowest vector first. */
+#define KSTAT_IRQ	4
+typedef struct ece391_irq_stat {
+	uint32_t vector;
+	uint32_t count;
+	uint32_t time_us;	/* total time spent in the handler */
+	uint32_t avg_cycles;	/* TSC cycles per call */
+} ece391_irq_stat_t;
+
+/* KSTAT_SYSCALL gives one ece391_sys_stat_t for every syscall number that
+ * user programs have made since boot, lowest number first. A call's time
+ * includes any time it spent blocked; execute stops counting when the new
+ * program starts. */
+#define KSTAT_SYSCALL	5
+typedef struct ece391_sys_stat {
+	uint32_t num;
+	uint32_t count;
+	uint32_t total_us;
+	uint32_t avg_cycles;
+	uint32_t max_cycles;
+} ece391_sys_stat_t;
+
+/* KSTAT_STRACE moves out the syscalls recorded for traced processes,
+ * oldest first. seq goes up by one per record, a gap means the ring
+ * filled up and older records were overwritten. */
+#define KSTAT_STRACE	6
+#define STRACE_STR_LEN	32
+typedef struct ece391_strace_rec {
+	uint32_t seq;
+	uint32_t pid;
+	uint32_t num;
+	uint32_t args[3];
+	int32_t ret;
+	uint32_t usec;		/* entry to return, including time blocked */
+	char str[STRACE_STR_LEN];	/* first arg of execute and open */
+} ece391_strace_rec_t;
+extern int32_t ece391_kstat (int32_t which, void* buf, int32_t nbytes);
+
+/* Sampling profiler. START throws away the last run and starts sampling,
+ * STOP stops it and DUMP stops it and writes every sample to the serial
+ * port (see student-distrib/symbolize.py). All return the number of
+ * samples taken. */
+#define PROFILE_START	0
+#define PROFILE_STOP	1
+#define PROFILE_DUMP	2
+extern int32_t ece391_profile (int32_t cmd);
+
+/* Syscall tracing. Turns recording on or off for pid and everything it
+ * executes; pid -1 means whatever the caller executes from now on. */
+#define STRACE_CHILDREN_PID	(-1)
+extern int32_t ece391_strace (int32_t pid, int32_t on);
+
+/* Terminal input modes, fd is 0 or 1. TERM_RAW reads return each key as
+ * it is pressed (up/down as ESC [ A / ESC [ B, Ctrl+letter as 1-26) with
+ * no echo. TERM_NONBLOCK reads return 0 when there is nothing to read.
+ * When the program halts the mode goes back to what its parent was using. */
+#define TERM_GETMODE	0
+#define TERM_SETMODE	1
+#define TERM_RAW	0x1
+#define TERM_NONBLOCK	0x2
+extern int32_t ece391_ioctl (int32_t fd, int32_t cmd, uint32_t arg);
+
+/* Kernel trace events (KSTAT_TRACE) are only recorded between START and
+ * STOP. START throws away the events nobody read. Both return 0. */
+#define TRACE_START	0
+#define TRACE_STOP	1
+extern int32_t ece391_trace (int32_t cmd);
+
 enum signums {
 	DIV_ZERO = 0,
 	SEGFAULT,
@@ -0,0 +1,64 @@
+#if !defined(ECE391SYSNAME_H)
+#define ECE391SYSNAME_H
+
+#include <stdint.h>
+
+#include "ece391sysnum.h"
+
+/* Name and number of args of each syscall, indexed by its SYS_ number
+ * (0 is not a syscall). A new syscall needs an entry in both tables. */
+static const char* const syscall_names[] = {
+    [0]                 = "?",
+    [SYS_HALT]          = "halt",
+    [SYS_EXECUTE]       = "execute",
+    [SYS_READ]          = "read",
+    [SYS_WRITE]         = "write",
+    [SYS_OPEN]          = "open",
+    [SYS_CLOSE]         = "close",
+    [SYS_GETARGS]       = "getargs",
+    [SYS_VIDMAP]        = "vidmap",
+    [SYS_SET_HANDLER]   = "set_handler",
+    [SYS_SIGRETURN]     = "sigreturn",
+    [SYS_MALLOC]        = "malloc",
+    [SYS_FREE]          = "free",
+    [SYS_NICE]          = "nice",
+    [SYS_YIELD]         = "yield",
+    [SYS_SLEEP]         = "sleep",
+    [SYS_CLOCK_GETTIME] = "clock_gettime",
+    [SYS_GETRUSAGE]     = "getrusage",
+    [SYS_KSTAT]         = "kstat",
+    [SYS_PROFILE]       = "profile",
+    [SYS_STRACE]        = "strace",
+    [SYS_IOCTL]         = "ioctl",
+    [SYS_TRACE]         = "trace",
+};
+
+#define NUM_SYSCALLS    (sizeof (syscall_names) / sizeof (syscall_names[0]))
+
+static const uint8_t syscall_args[NUM_SYSCALLS] = {
+    [0]                 = 0,
+    [SYS_HALT]          = 1,
+    [SYS_EXECUTE]       = 1,
+    [SYS_READ]          = 3,
+    [SYS_WRITE]         = 3,
+    [SYS_OPEN]          = 1,
+    [SYS_CLOSE]         = 1,
+    [SYS_GETARGS]       = 2,
+    [SYS_VIDMAP]        = 1,
+    [SYS_SET_HANDLER]   = 2,
+    [SYS_SIGRETURN]     = 0,
+    [SYS_MALLOC]        = 1,
+    [SYS_FREE]          = 1,
+    [SYS_NICE]          = 2,
+    [SYS_YIELD]         = 0,
+    [SYS_SLEEP]         = 1,
+    [SYS_CLOCK_GETTIME] = 1,
+    [SYS_GETRUSAGE]     = 2,
+    [SYS_KSTAT]         = 3,
+    [SYS_PROFILE]       = 1,
+    [SYS_STRACE]        = 2,
+    [SYS_IOCTL]         = 3,
+    [SYS_TRACE]         = 1,
+};
+
+#endif /* ECE391SYSNAME_H */
@@ -13,5 +13,15 @@
 #define SYS_SIGRETURN  10
 #define SYS_MALLOC  11
 #define SYS_FREE    12
+#define SYS_NICE    13
+#define SYS_YIELD   14
+#define SYS_SLEEP   15
+#define SYS_CLOCK_GETTIME  16
+#define SYS_GETRUSAGE  17
+#define SYS_KSTAT   18
+#define SYS_PROFILE 19
+#define SYS_STRACE  20
+#define SYS_IOCTL   21
+#define SYS_TRACE   22
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,120 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+#include "ece391sysname.h"
+
+/*
+ * Shows how often each syscall has been made and how long it took, busiest
+ * first. With a command ("sysstat grep very") only the calls made while the
+ * command ran are shown, but max cycles still covers everything since boot.
+ */
+
+#define BUFSIZE         128
+#define NUMSIZE         16
+#define MAX_CALLS       32
+
+static ece391_sys_stat_t before[MAX_CALLS], after[MAX_CALLS];
+
+static void put_str (const char* s)
+{
+    ece391_fdputs (1, (const uint8_t*)s);
+}
+
+static void put_str_width (const char* s, uint32_t width)
+{
+    uint32_t len;
+
+    put_str (s);
+    for (len = ece391_strlen ((const uint8_t*)s); len < width; len++)
+        put_str (" ");
+}
+
+static void put_num_width (uint32_t value, uint32_t width)
+{
+    uint8_t buf[NUMSIZE];
+    uint32_t len;
+
+    ece391_itoa (value, buf, 10);
+    for (len = ece391_strlen (buf); len < width; len++)
+        put_str (" ");
+    ece391_fdputs (1, buf);
+}
+
+/* part * 100 / whole without overflowing */
+static uint32_t percent (uint32_t part, uint32_t whole)
+{
+    if (whole >= 100)
+        return part / (whole / 100);
+    return part * 100 / whole;
+}
+
+/* Turns after[] into the calls made since before[] was read (both sorted by number) */
+static int32_t subtract (int32_t na, int32_t nb)
+{
+    int32_t i, j = 0, n = 0;
+
+    for (i = 0; i < na; i++) {
+        after[n] = after[i];
+        while (j < nb && before[j].num < after[i].num)
+            j++;
+        if (j < nb && before[j].num == after[i].num) {
+            after[n].count -= before[j].count;
+            after[n].total_us -= before[j].total_us;
+        }
+        if (after[n].count == 0)
+            continue;
+        n++;
+    }
+    return n;
+}
+
+int main ()
+{
+    uint8_t cmd[BUFSIZE];
+    ece391_sys_stat_t tmp;
+    uint32_t total_us = 0;
+    int32_t n, nb = 0, i, j, delta = 0;
+
+    if (0 == ece391_getargs (cmd, BUFSIZE) && '\0' != cmd[0]) {
+        delta = 1;
+        nb = ece391_kstat (KSTAT_SYSCALL, before, sizeof (before));
+        if (-1 == ece391_execute (cmd)) {
+            put_str ("sysstat: no such command\n");
+            return 2;
+        }
+    }
+
+    n = ece391_kstat (KSTAT_SYSCALL, after, sizeof (after));
+    if (n < 0 || nb < 0) {
+        put_str ("sysstat: kstat failed\n");
+        return 2;
+    }
+    if (delta)
+        n = subtract (n, nb);
+
+    /* Busiest first */
+    for (i = 1; i < n; i++) {
+        tmp = after[i];
+        for (j = i; j > 0 && after[j - 1].total_us < tmp.total_us; j--)
+            after[j] = after[j - 1];
+        after[j] = tmp;
+    }
+    for (i = 0; i < n; i++)
+        total_us += after[i].total_us;
+    if (0 == total_us)
+        total_us = 1;
+
+    put_str ("syscall             calls    total ms    avg us  max cycles  time%\n");
+    for (i = 0; i < n; i++) {
+        put_str_width (after[i].num < NUM_SYSCALLS ? syscall_names[after[i].num] : "?", 14);
+        put_num_width (after[i].count, 11);
+        put_num_width (after[i].total_us / 1000, 12);
+        put_num_width (after[i].total_us / after[i].count, 10);
+        put_num_width (after[i].max_cycles, 12);
+        put_num_width (percent (after[i].total_us, total_us), 7);
+        put_str ("\n");
+    }
+
+    return 0;
+}
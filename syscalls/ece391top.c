@@ -0,0 +1,170 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * Shows every process with its state and CPU usage, refreshed twice a second
+ * for a number of seconds (e.g. "top 60"). Each frame is built off screen and
+ * copied into video memory in one pass, so the screen never shows a half
+ * drawn or cleared frame.
+ */
+
+#define BUFSIZE         32
+#define DEFAULT_SECS    30
+#define MAX_SECS        3600
+#define REFRESH_HZ      2
+
+#define COLS            80
+#define ROWS            25
+#define ATTR            0x0C    /* Same as the kernel's text */
+#define ATTR_HEAD       0x70
+
+#define MAX_PROCS       8       /* More than the kernel has pids */
+
+static uint16_t frame[ROWS * COLS];
+
+/* Writes s at (row, col), clipped to the end of the row */
+static void put_str (int32_t row, int32_t col, const uint8_t* s, uint8_t attr)
+{
+    for (; *s != '\0' && col < COLS; s++, col++)
+        frame[row * COLS + col] = (attr << 8) | *s;
+}
+
+/* Writes value right aligned so its last digit lands in column end - 1 */
+static void put_num (int32_t row, int32_t end, uint32_t value, uint8_t attr)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_itoa (value, buf, 10);
+    put_str (row, end - ece391_strlen (buf), buf, attr);
+}
+
+/* Signed version of put_num */
+static void put_int (int32_t row, int32_t end, int32_t value, uint8_t attr)
+{
+    uint8_t buf[BUFSIZE];
+
+    if (value >= 0) {
+        put_num (row, end, value, attr);
+        return;
+    }
+    buf[0] = '-';
+    ece391_itoa (-value, buf + 1, 10);
+    put_str (row, end - ece391_strlen (buf), buf, attr);
+}
+
+/* Writes ms as seconds with two decimals, right aligned like put_num */
+static void put_secs (int32_t row, int32_t end, uint32_t ms, uint8_t attr)
+{
+    uint32_t cs = (ms / 10) % 100;
+
+    put_num (row, end - 3, ms / 1000, attr);
+    frame[row * COLS + end - 3] = (attr << 8) | '.';
+    frame[row * COLS + end - 2] = (attr << 8) | ('0' + cs / 10);
+    frame[row * COLS + end - 1] = (attr << 8) | ('0' + cs % 10);
+}
+
+static void clear_frame (void)
+{
+    int32_t i;
+
+    for (i = 0; i < ROWS * COLS; i++)
+        frame[i] = (ATTR << 8) | ' ';
+}
+
+int main ()
+{
+    static const uint8_t* states[] = {(uint8_t*)"run", (uint8_t*)"sleep", (uint8_t*)"wait"};
+    const ece391_vdso_t* vdso = ECE391_VDSO;
+    ece391_procstat_t ps[MAX_PROCS];
+    uint32_t last_cpu[MAX_PROCS];       /* utime + stime at the last frame, by pid */
+    uint8_t buf[BUFSIZE];
+    uint8_t* screen;
+    uint16_t* vmem;
+    uint32_t secs = 0, frames, now, last, elapsed, cpu, up;
+    int32_t rtc_fd, rate, n, i, row, garbage;
+
+    if (0 == ece391_getargs (buf, BUFSIZE)) {
+        for (i = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+            secs = secs * 10 + (buf[i] - '0');
+    }
+    if (0 == secs || secs > MAX_SECS)
+        secs = DEFAULT_SECS;
+
+    if (-1 == ece391_vidmap (&screen)) {
+        ece391_fdputs (1, (uint8_t*)"top: vidmap failed\n");
+        return 2;
+    }
+    vmem = (uint16_t*)screen;
+
+    rtc_fd = ece391_open ((uint8_t*)"rtc");
+    rate = REFRESH_HZ;
+    if (-1 == rtc_fd || -1 == ece391_write (rtc_fd, &rate, 4)) {
+        ece391_fdputs (1, (uint8_t*)"top: cannot open rtc\n");
+        return 2;
+    }
+
+    for (i = 0; i < MAX_PROCS; i++)
+        last_cpu[i] = 0;
+    last = vdso->ticks;
+
+    for (frames = 0; frames < secs * REFRESH_HZ; frames++) {
+        ece391_read (rtc_fd, &garbage, 4);
+
+        n = ece391_kstat (KSTAT_PROC, ps, sizeof (ps));
+        now = vdso->ticks;
+        elapsed = (now - last) * vdso->tick_ms;
+        last = now;
+
+        clear_frame ();
+
+        up = now * vdso->tick_ms / 1000;
+        put_str (0, 0, (uint8_t*)"top - up ", ATTR);
+        put_num (0, 11, up / 3600, ATTR);
+        put_str (0, 11, (uint8_t*)":", ATTR);
+        put_num (0, 13, (up / 60) % 60 / 10, ATTR);
+        put_num (0, 14, (up / 60) % 60 % 10, ATTR);
+        put_str (0, 14, (uint8_t*)":", ATTR);
+        put_num (0, 16, up % 60 / 10, ATTR);
+        put_num (0, 17, up % 60 % 10, ATTR);
+        put_str (0, 19, (uint8_t*)"processes:", ATTR);
+        put_num (0, 31, n, ATTR);
+        put_str (0, 33, (uint8_t*)"left:", ATTR);
+        put_num (0, 42, (secs * REFRESH_HZ - frames) / REFRESH_HZ, ATTR);
+        put_str (0, 42, (uint8_t*)"s", ATTR);
+
+        for (i = 0; i < COLS; i++)
+            frame[2 * COLS + i] = (ATTR_HEAD << 8) | ' ';
+        put_str (2, 0, (uint8_t*)"  PID  PPID TTY STATE  NI  %CPU    USER     SYS    MEM FDS COMMAND", ATTR_HEAD);
+
+        for (i = 0, row = 3; i < n && row < ROWS; i++, row++) {
+            cpu = ps[i].utime_ms + ps[i].stime_ms;
+
+            put_num (row, 5, ps[i].pid, ATTR);
+            put_int (row, 11, ps[i].parent_pid, ATTR);
+            put_num (row, 15, ps[i].terminal, ATTR);
+            if (ps[i].state >= 0 && ps[i].state <= PROC_WAITING)
+                put_str (row, 16, states[ps[i].state], ATTR);
+            put_int (row, 25, ps[i].nice, ATTR);
+            /* A pid reused since the last frame shows a bogus first sample, it's gone next frame */
+            if (elapsed > 0 && ps[i].pid < MAX_PROCS && cpu >= last_cpu[ps[i].pid])
+                put_num (row, 31, (cpu - last_cpu[ps[i].pid]) * 100 / elapsed, ATTR);
+            put_secs (row, 39, ps[i].utime_ms, ATTR);
+            put_secs (row, 47, ps[i].stime_ms, ATTR);
+            put_num (row, 53, ps[i].mem_bytes >> 10, ATTR);
+            put_str (row, 53, (uint8_t*)"K", ATTR);
+            put_num (row, 58, ps[i].open_fds, ATTR);
+            put_str (row, 59, ps[i].name, ATTR);
+
+            if (ps[i].pid < MAX_PROCS)
+                last_cpu[ps[i].pid] = cpu;
+        }
+
+        for (i = 0; i < ROWS * COLS; i++)
+            vmem[i] = frame[i];
+    }
+
+    ece391_close (rtc_fd);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+#include "ece391sysname.h"
+
+/*
+ * Prints the kernel trace events recorded since the last run (the rings
+ * keep the last 2048 per CPU). Events are read before anything is printed,
+ * otherwise the write calls made while printing would keep adding more.
+ *
+ * The kernel only records while tracing is on: "trace start" and "trace
+ * stop" turn it on and off, "trace <command>" records just while the
+ * command runs and then prints what it got.
+ */
+
+#define BUFSIZE         16
+#define CMDSIZE         128
+#define MAX_EVENTS      2048
+
+static ece391_trace_event_t events[MAX_EVENTS];
+
+static const char* event_names[] = {
+    "?", "sched", "syscall", "execute", "halt", "rtc", "keyboard", "tick"
+};
+
+static void put_str (const char* s)
+{
+    ece391_fdputs (1, (const uint8_t*)s);
+}
+
+static void put_num (uint32_t value, int32_t radix)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_itoa (value, buf, radix);
+    ece391_fdputs (1, buf);
+}
+
+/* Prints pids and the like, which can be -1 */
+static void put_int (int32_t value)
+{
+    if (value < 0) {
+        put_str ("-");
+        value = -value;
+    }
+    put_num (value, 10);
+}
+
+/* Prints value in width columns, padded on the left with pad */
+static void put_num_pad (uint32_t value, uint32_t width, const char* pad)
+{
+    uint8_t buf[BUFSIZE];
+    uint32_t len;
+
+    ece391_itoa (value, buf, 10);
+    for (len = ece391_strlen (buf); len < width; len++)
+        put_str (pad);
+    ece391_fdputs (1, buf);
+}
+
+static void print_event (const ece391_trace_event_t* ev)
+{
+    put_num_pad (ev->sec, 5, " ");
+    put_str (".");
+    put_num_pad (ev->nsec / 1000, 6, "0");
+    put_str (" cpu");
+    put_num (ev->cpu, 10);
+    put_str (" pid");
+    put_num (ev->pid, 10);
+    put_str (" ");
+    put_str (ev->id <= TRACE_TICK ? event_names[ev->id] : event_names[0]);
+    put_str (" ");
+
+    switch (ev->id) {
+    case TRACE_SYSCALL:
+        put_str (ev->args[0] < NUM_SYSCALLS ? syscall_names[ev->args[0]] : syscall_names[0]);
+        put_str ("(0x");
+        put_num (ev->args[1], 16);
+        put_str (", 0x");
+        put_num (ev->args[2], 16);
+        put_str (")");
+        break;
+    case TRACE_RTC:
+        put_str ("terminals 0x");
+        put_num (ev->args[0], 16);
+        break;
+    case TRACE_KEYBOARD:
+        put_str ("0x");
+        put_num (ev->args[0], 16);
+        put_str (" terminal ");
+        put_num (ev->args[1], 10);
+        break;
+    case TRACE_TICK:
+        put_num (ev->args[0], 10);
+        put_str (ev->args[1] ? " lapic" : " pit");
+        break;
+    default:
+        put_int (ev->args[0]);
+        put_str (" ");
+        put_int (ev->args[1]);
+        put_str (" ");
+        put_int (ev->args[2]);
+        break;
+    }
+    put_str ("\n");
+}
+
+int main ()
+{
+    uint8_t cmd[CMDSIZE];
+    int32_t n, i, ret;
+
+    if (0 == ece391_getargs (cmd, CMDSIZE) && '\0' != cmd[0]) {
+        if (0 == ece391_strcmp (cmd, (uint8_t*)"start"))
+            return ece391_trace (TRACE_START);
+        if (0 == ece391_strcmp (cmd, (uint8_t*)"stop"))
+            return ece391_trace (TRACE_STOP);
+
+        ece391_trace (TRACE_START);
+        ret = ece391_execute (cmd);
+        ece391_trace (TRACE_STOP);
+        if (-1 == ret) {
+            put_str ("trace: no such command\n");
+            return 2;
+        }
+    }
+
+    /* One read only, while tracing is on every kstat call traces itself so there would always be one more */
+    n = ece391_kstat (KSTAT_TRACE, events, sizeof (events));
+    if (n < 0) {
+        put_str ("trace: kstat failed\n");
+        return 2;
+    }
+
+    for (i = 0; i < n; i++)
+        print_event (&events[i]);
+
+    if (0 == n)
+        put_str ("trace: no events (\"trace start\" or \"trace <command>\" records some)\n");
+
+    return 0;
+}